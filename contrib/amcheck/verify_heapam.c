@@ -1792,10 +1792,12 @@ check_tuple_attribute(HeapCheckContext *ctx)
 				/* List of all valid compression method IDs */
 			case TOAST_PGLZ_COMPRESSION_ID:
 			case TOAST_LZ4_COMPRESSION_ID:
+			case TOAST_ZSTD_COMPRESSION_ID:
 				valid = true;
 				break;
 
 				/* Recognized but invalid compression method ID */
+			case TOAST_EXTENDED_COMPRESSION_ID:
 			case TOAST_INVALID_COMPRESSION_ID:
 				break;
 
@@ -57,3 +57,25 @@ SELECT keys AS keys_leaf_1
   WHERE itemoffset = 1;
 
 DROP TABLE test_gist;
+
+-- Bottom-up deletion.  Non-HOT updates that leave the indexed point alone
+-- should remove the old versions from the leaf page, instead of splitting
+-- it.  The btree index on v keeps the updates from being HOT.
+CREATE TABLE test_gist_bud (p point, v int) WITH (autovacuum_enabled = off);
+CREATE INDEX test_gist_bud_p ON test_gist_bud USING gist (p);
+CREATE INDEX test_gist_bud_v ON test_gist_bud (v);
+INSERT INTO test_gist_bud VALUES (point(1, 1), 0);
+DO $$
+BEGIN
+  FOR i IN 1..1000 LOOP
+    UPDATE test_gist_bud SET v = v + 1;
+    COMMIT;
+  END LOOP;
+END $$;
+-- The root is still the only leaf page
+SELECT pg_relation_size('test_gist_bud_p') / :block_size AS blocks;
+SELECT flags FROM gist_page_opaque_info(get_raw_page('test_gist_bud_p', 0));
+SELECT count(*) < 1001 AS versions_removed
+  FROM gist_page_items(get_raw_page('test_gist_bud_p', 0), 'test_gist_bud_p');
+
+DROP TABLE test_gist_bud;
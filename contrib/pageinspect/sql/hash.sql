@@ -109,5 +109,28 @@ SELECT hash_page_items(decode(repeat('00', :block_size), 'hex'));
 SELECT hash_page_stats(decode(repeat('00', :block_size), 'hex'));
 SELECT hash_page_type(decode(repeat('00', :block_size), 'hex'));
 
+-- Bottom-up deletion.  Non-HOT updates that leave the hashed key alone
+-- should remove the old versions from the bucket page, instead of adding
+-- overflow pages.  The btree index on v keeps the updates from being HOT.
+CREATE TABLE test_hash_bud (id int, v int) WITH (autovacuum_enabled = off);
+CREATE INDEX test_hash_bud_id ON test_hash_bud USING hash (id);
+CREATE INDEX test_hash_bud_v ON test_hash_bud (v);
+INSERT INTO test_hash_bud VALUES (1, 0);
+DO $$
+BEGIN
+  FOR i IN 1..1000 LOOP
+    UPDATE test_hash_bud SET v = v + 1;
+    COMMIT;
+  END LOOP;
+END $$;
+SELECT count(*) AS overflow_pages
+  FROM generate_series(1, pg_relation_size('test_hash_bud_id') / :block_size - 1) b
+  WHERE hash_page_type(get_raw_page('test_hash_bud_id', b)) = 'overflow';
+SELECT sum((hash_page_stats(get_raw_page('test_hash_bud_id', b))).live_items) < 1001
+    AS versions_removed
+  FROM generate_series(1, pg_relation_size('test_hash_bud_id') / :block_size - 1) b
+  WHERE hash_page_type(get_raw_page('test_hash_bud_id', b)) = 'bucket';
+
 DROP TABLE test_hash;
 DROP TABLE test_hash_part;
+DROP TABLE test_hash_bud;
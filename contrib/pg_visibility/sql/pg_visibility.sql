@@ -164,6 +164,22 @@ commit;
 select * from pg_visibility_map('copyfreeze');
 select * from pg_check_frozen('copyfreeze');
 
+-- On-access pruning sets the all-visible bit, but not the all-frozen bit.
+-- HOT-update a row on the first page, in one transaction, until the page's
+-- free space drops below the pruning threshold.
+create table prunevisible (a int, b text)
+  with (autovacuum_enabled = false, fillfactor = 90);
+insert into prunevisible select g, repeat('x', 100) from generate_series(1, 100) g;
+begin;
+update prunevisible set a = a where a = 1;
+update prunevisible set a = a where a = 1;
+update prunevisible set a = a where a = 1;
+commit;
+select * from pg_visibility_map('prunevisible', 0);
+-- a scan prunes the page, leaving only tuples visible to everyone
+select count(*) from prunevisible;
+select * from pg_visibility('prunevisible', 0);
+
 -- cleanup
 drop table test_partitioned;
 drop view test_view;
@@ -174,3 +190,4 @@ drop foreign data wrapper dummy;
 drop materialized view matview_visibility_test;
 drop table regular_table;
 drop table copyfreeze;
+drop table prunevisible;
@@ -38,6 +38,7 @@
 #include "utils/datum.h"
 #include "utils/fmgrprotos.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/index_selfuncs.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -194,6 +195,9 @@ typedef struct BrinInsertState
 	BrinRevmap *bis_rmAccess;
 	BrinDesc   *bis_desc;
 	BlockNumber bis_pages_per_range;
+	BlockNumber bis_heap_nblocks;	/* heap size when first needed */
+	HTAB	   *bis_resummarize;	/* ranges requested for resummarization */
+	bool		bis_resummarize_full;	/* work item queue was found full */
 } BrinInsertState;
 
 /*
@@ -213,6 +217,9 @@ static BrinBuildState *initialize_brin_buildstate(Relation idxRel,
 												  BlockNumber pagesPerRange,
 												  BlockNumber tablePages);
 static BrinInsertState *initialize_brin_insertstate(Relation idxRel, IndexInfo *indexInfo);
+static void brin_request_resummarize(Relation idxRel, Relation heapRel,
+									 BrinInsertState *bistate,
+									 BlockNumber heapBlk);
 static void terminate_brin_buildstate(BrinBuildState *state);
 static void brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 						  bool include_partial, double *numSummarized, double *numExisting);
@@ -279,6 +286,7 @@ brinhandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = brinbuild;
 	amroutine->ambuildempty = brinbuildempty;
+	amroutine->ambuildusesworkers = NULL;
 	amroutine->aminsert = brininsert;
 	amroutine->aminsertcleanup = brininsertcleanup;
 	amroutine->ambulkdelete = brinbulkdelete;
@@ -322,6 +330,7 @@ initialize_brin_insertstate(Relation idxRel, IndexInfo *indexInfo)
 	bistate->bis_desc = brin_build_desc(idxRel);
 	bistate->bis_rmAccess = brinRevmapInitialize(idxRel,
 												 &bistate->bis_pages_per_range);
+	bistate->bis_heap_nblocks = InvalidBlockNumber;
 	indexInfo->ii_AmCache = bistate;
 	MemoryContextSwitchTo(oldcxt);
 
@@ -335,7 +344,8 @@ initialize_brin_insertstate(Relation idxRel, IndexInfo *indexInfo)
  * the summary tuple, we need to update the index tuple.
  *
  * If autosummarization is enabled, check if we need to summarize the previous
- * page range.
+ * page range, and whether a widened summary of an older range should be
+ * recomputed.
  *
  * If the range is not currently summarized (i.e. the revmap returns NULL for
  * it), there's nothing to do for this tuple.
@@ -490,6 +500,13 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 				MemoryContextReset(tupcxt);
 				continue;
 			}
+
+			/*
+			 * If we widened the summary of a range other than the last one in
+			 * the table, have it computed afresh.
+			 */
+			if (autosummarize)
+				brin_request_resummarize(idxRel, heapRel, bistate, heapBlk);
 		}
 
 		/* success! */
@@ -505,6 +522,74 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 	return false;
 }
 
+/*
+ * Ask autovacuum to resummarize the range starting at heapBlk, whose summary
+ * brininsert just widened, unless it is the last range of the table.
+ *
+ * Ranges other than the last one get new tuples when they reuse space freed
+ * by vacuum, when the table has a fillfactor below 100, and from HOT updates,
+ * which insert into summarizing indexes on the old tuple's page.  In all
+ * those cases the summary keeps covering values that are no longer there,
+ * or soon won't be.  The work item computes it afresh once the next
+ * autovacuum run of the database is done; if the superseded tuple versions
+ * are still visible to someone at that point, the new summary is just as
+ * wide and the work is wasted.  That's why autovacuum lets these requests
+ * take up only part of its work item queue.
+ *
+ * Each range is requested at most once per statement, and once a request has
+ * been refused, the statement makes (and logs) no more requests.
+ */
+static void
+brin_request_resummarize(Relation idxRel, Relation heapRel,
+						 BrinInsertState *bistate, BlockNumber heapBlk)
+{
+	bool		found;
+
+	if (bistate->bis_resummarize_full)
+		return;
+
+	/*
+	 * Ranges past the end of the heap as it was when we first got here have
+	 * been filled by this statement, so their summaries aren't stale.  That
+	 * lets us measure the heap only once per statement.
+	 */
+	if (bistate->bis_heap_nblocks == InvalidBlockNumber)
+		bistate->bis_heap_nblocks = RelationGetNumberOfBlocks(heapRel);
+	if ((uint64) heapBlk + bistate->bis_pages_per_range >=
+		(uint64) bistate->bis_heap_nblocks)
+		return;
+
+	if (bistate->bis_resummarize == NULL)
+	{
+		HASHCTL		hash_ctl;
+
+		hash_ctl.keysize = sizeof(BlockNumber);
+		hash_ctl.entrysize = sizeof(BlockNumber);
+		hash_ctl.hcxt = GetMemoryChunkContext(bistate);
+		bistate->bis_resummarize = hash_create("BRIN ranges to resummarize",
+											   64, &hash_ctl,
+											   HASH_ELEM | HASH_BLOBS |
+											   HASH_CONTEXT);
+	}
+
+	(void) hash_search(bistate->bis_resummarize, &heapBlk, HASH_ENTER, &found);
+	if (found)
+		return;
+
+	if (!AutoVacuumRequestWork(AVW_BRINResummarizeRange,
+							   RelationGetRelid(idxRel),
+							   heapBlk))
+	{
+		bistate->bis_resummarize_full = true;
+		ereport(LOG,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("request for BRIN range resummarization for index \"%s\" page %u was not recorded",
+						RelationGetRelationName(idxRel),
+						heapBlk),
+				 errdetail("No further ranges will be requested for resummarization by this statement.")));
+	}
+}
+
 /*
  * Callback to clean up the BrinInsertState once all tuple inserts are done.
  */
@@ -525,6 +610,8 @@ brininsertcleanup(Relation index, IndexInfo *indexInfo)
 	 * as part of its own memory context.
 	 */
 	brinRevmapTerminate(bistate->bis_rmAccess);
+	if (bistate->bis_resummarize != NULL)
+		hash_destroy(bistate->bis_resummarize);
 	pfree(bistate);
 }
 
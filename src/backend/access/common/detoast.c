@@ -191,6 +191,63 @@ detoast_attr(struct varlena *attr)
 }
 
 
+/* ----------
+ * detoast_attr_into -
+ *
+ *	Write the fully detoasted data of a varlena, without any header, into
+ *	dest, which must have room for toast_raw_datum_size(attr) - VARHDRSZ
+ *	bytes.
+ *
+ * This is meant for callers that are only going to copy the value into some
+ * other buffer anyway, such as an outgoing protocol message.  An uncompressed
+ * value in external storage is fetched chunk by chunk straight into dest,
+ * without building a palloc'd copy of the whole value first; for anything
+ * else we fall back to detoast_attr() and copy the result.
+ * ----------
+ */
+void
+detoast_attr_into(struct varlena *attr, char *dest)
+{
+	struct varlena *tmp;
+
+	if (VARATT_IS_EXTERNAL_ONDISK(attr))
+	{
+		struct varatt_external toast_pointer;
+
+		/* Must copy to access aligned fields */
+		VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+
+		if (!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+		{
+			int32		attrsize = VARATT_EXTERNAL_GET_EXTSIZE(toast_pointer);
+			Relation	toastrel;
+
+			if (attrsize == 0)
+				return;
+
+			toastrel = table_open(toast_pointer.va_toastrelid, AccessShareLock);
+
+			/*
+			 * The fetch routine writes into VARDATA() of the varlena it is
+			 * given and must not touch the header (see
+			 * table_relation_fetch_toast_slice()), so hand it a pointer
+			 * positioned so that its data area is dest.
+			 */
+			table_relation_fetch_toast_slice(toastrel, toast_pointer.va_valueid,
+											 attrsize, 0, attrsize,
+											 (struct varlena *) (dest - VARHDRSZ));
+
+			table_close(toastrel, AccessShareLock);
+			return;
+		}
+	}
+
+	tmp = detoast_attr(attr);
+	memcpy(dest, VARDATA_ANY(tmp), VARSIZE_ANY_EXHDR(tmp));
+	if (tmp != attr)
+		pfree(tmp);
+}
+
 /* ----------
  * detoast_attr_slice -
  *
@@ -485,6 +542,8 @@ toast_decompress_datum(struct varlena *attr)
 			return pglz_decompress_datum(attr);
 		case TOAST_LZ4_COMPRESSION_ID:
 			return lz4_decompress_datum(attr);
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return zstd_decompress_datum(attr);
 		default:
 			elog(ERROR, "invalid compression method id %d", cmid);
 			return NULL;		/* keep compiler quiet */
@@ -528,6 +587,8 @@ toast_decompress_datum_slice(struct varlena *attr, int32 slicelength)
 			return pglz_decompress_datum_slice(attr, slicelength);
 		case TOAST_LZ4_COMPRESSION_ID:
 			return lz4_decompress_datum_slice(attr, slicelength);
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return zstd_decompress_datum_slice(attr, slicelength);
 		default:
 			elog(ERROR, "invalid compression method id %d", cmid);
 			return NULL;		/* keep compiler quiet */
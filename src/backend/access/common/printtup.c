@@ -15,10 +15,12 @@
  */
 #include "postgres.h"
 
+#include "access/detoast.h"
 #include "access/printtup.h"
 #include "libpq/pqformat.h"
 #include "libpq/protocol.h"
 #include "tcop/pquery.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memdebug.h"
 #include "utils/memutils.h"
@@ -364,12 +366,7 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 		else
 		{
 			/* Binary output */
-			bytea	   *outputbytes;
-
-			outputbytes = SendFunctionCall(&thisState->finfo, attr);
-			pq_sendint32(buf, VARSIZE(outputbytes) - VARHDRSZ);
-			pq_sendbytes(buf, VARDATA(outputbytes),
-						 VARSIZE(outputbytes) - VARHDRSZ);
+			SendBinaryAttribute(buf, &thisState->finfo, attr);
 		}
 	}
 
@@ -382,6 +379,43 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 	return true;
 }
 
+/* ----------------
+ *		SendBinaryAttribute --- append the binary output of one attribute
+ *
+ * The value is produced by the send function finfo and appended to buf as
+ * an int32 length word followed by the data, as in a DataRow message or a
+ * binary COPY row.
+ *
+ * byteasend() would just return the detoasted value, so for a bytea stored
+ * out of line we skip it and detoast directly into buf, saving a full-size
+ * copy of what may be a very large value.
+ * ----------------
+ */
+void
+SendBinaryAttribute(StringInfo buf, FmgrInfo *finfo, Datum attr)
+{
+	bytea	   *outputbytes;
+
+	if (finfo->fn_oid == F_BYTEASEND &&
+		VARATT_IS_EXTERNAL_ONDISK(DatumGetPointer(attr)))
+	{
+		int32		len = toast_raw_datum_size(attr) - VARHDRSZ;
+
+		pq_sendint32(buf, len);
+		enlargeStringInfo(buf, len);
+		detoast_attr_into((struct varlena *) DatumGetPointer(attr),
+						  buf->data + buf->len);
+		buf->len += len;
+		buf->data[buf->len] = '\0';
+		return;
+	}
+
+	outputbytes = SendFunctionCall(finfo, attr);
+	pq_sendint32(buf, VARSIZE(outputbytes) - VARHDRSZ);
+	pq_sendbytes(buf, VARDATA(outputbytes),
+				 VARSIZE(outputbytes) - VARHDRSZ);
+}
+
 /* ----------------
  *		printtup_shutdown
  * ----------------
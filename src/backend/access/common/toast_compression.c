@@ -16,6 +16,9 @@
 #ifdef USE_LZ4
 #include <lz4.h>
 #endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/detoast.h"
 #include "access/toast_compression.h"
@@ -25,6 +28,12 @@
 /* GUC */
 int			default_toast_compression = TOAST_PGLZ_COMPRESSION;
 
+#ifdef USE_ZSTD
+/* zstd contexts, created on first use and kept for the life of the process */
+static ZSTD_CCtx *zstd_cctx = NULL;
+static ZSTD_DCtx *zstd_dctx = NULL;
+#endif
+
 #define NO_COMPRESSION_SUPPORT(method) \
 	ereport(ERROR, \
 			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), \
@@ -245,6 +254,173 @@ lz4_decompress_datum_slice(const struct varlena *value, int32 slicelength)
 #endif
 }
 
+#ifdef USE_ZSTD
+/*
+ * Get the process's zstd decompression context, creating it if needed.
+ */
+static ZSTD_DCtx *
+zstd_get_dctx(void)
+{
+	if (zstd_dctx == NULL)
+	{
+		zstd_dctx = ZSTD_createDCtx();
+		if (zstd_dctx == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+	}
+	return zstd_dctx;
+}
+#endif
+
+/*
+ * Compress a varlena using ZSTD.
+ *
+ * Returns the compressed varlena, or NULL if compression fails.
+ */
+struct varlena *
+zstd_compress_datum(const struct varlena *value)
+{
+#ifndef USE_ZSTD
+	NO_COMPRESSION_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	int32		valsize;
+	size_t		len;
+	size_t		max_size;
+	struct varlena *tmp = NULL;
+
+	if (zstd_cctx == NULL)
+	{
+		zstd_cctx = ZSTD_createCCtx();
+		if (zstd_cctx == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+	}
+
+	valsize = VARSIZE_ANY_EXHDR(value);
+
+	/*
+	 * Figure out the maximum possible size of the ZSTD output, add the bytes
+	 * that will be needed for varlena overhead, and allocate that amount.
+	 */
+	max_size = ZSTD_compressBound(valsize);
+	tmp = (struct varlena *) palloc(max_size + VARHDRSZ_COMPRESSED);
+
+	len = ZSTD_compressCCtx(zstd_cctx,
+							(char *) tmp + VARHDRSZ_COMPRESSED, max_size,
+							VARDATA_ANY(value), valsize,
+							ZSTD_CLEVEL_DEFAULT);
+	if (ZSTD_isError(len))
+		elog(ERROR, "zstd compression failed: %s", ZSTD_getErrorName(len));
+
+	/* data is incompressible so just free the memory and return NULL */
+	if (len > (size_t) valsize)
+	{
+		pfree(tmp);
+		return NULL;
+	}
+
+	SET_VARSIZE_COMPRESSED(tmp, len + VARHDRSZ_COMPRESSED);
+
+	return tmp;
+#endif
+}
+
+/*
+ * Decompress a varlena that was compressed using ZSTD.
+ */
+struct varlena *
+zstd_decompress_datum(const struct varlena *value)
+{
+#ifndef USE_ZSTD
+	NO_COMPRESSION_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	size_t		rawsize;
+	struct varlena *result;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(VARDATA_COMPRESSED_GET_EXTSIZE(value) + VARHDRSZ);
+
+	/* decompress the data */
+	rawsize = ZSTD_decompressDCtx(zstd_get_dctx(),
+								  VARDATA(result),
+								  VARDATA_COMPRESSED_GET_EXTSIZE(value),
+								  (char *) value + VARHDRSZ_COMPRESSED,
+								  VARSIZE(value) - VARHDRSZ_COMPRESSED);
+	if (ZSTD_isError(rawsize) ||
+		rawsize != VARDATA_COMPRESSED_GET_EXTSIZE(value))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed zstd data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+#endif
+}
+
+/*
+ * Decompress part of a varlena that was compressed using ZSTD.
+ *
+ * The streaming API lets us stop as soon as the requested prefix has been
+ * produced, so only as much of the input as needed is decompressed.
+ */
+struct varlena *
+zstd_decompress_datum_slice(const struct varlena *value, int32 slicelength)
+{
+#ifndef USE_ZSTD
+	NO_COMPRESSION_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	ZSTD_DCtx  *dctx = zstd_get_dctx();
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	struct varlena *result;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+
+	in.src = (char *) value + VARHDRSZ_COMPRESSED;
+	in.size = VARSIZE(value) - VARHDRSZ_COMPRESSED;
+	in.pos = 0;
+	out.dst = VARDATA(result);
+	out.size = slicelength;
+	out.pos = 0;
+
+	/* discard any state left behind by an earlier error */
+	ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+
+	while (out.pos < out.size)
+	{
+		size_t		ret;
+
+		ret = ZSTD_decompressStream(dctx, &out, &in);
+		if (ZSTD_isError(ret))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg_internal("compressed zstd data is corrupt")));
+
+		/*
+		 * Our caller only asks for less than the whole value, so the frame
+		 * must not end, nor the input run out, before the slice is complete.
+		 * Unless the output buffer is full, the decoder has flushed all it
+		 * could from the input given.
+		 */
+		if (out.pos < out.size && (ret == 0 || in.pos == in.size))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg_internal("compressed zstd data is corrupt")));
+	}
+
+	SET_VARSIZE(result, out.pos + VARHDRSZ);
+
+	return result;
+#endif
+}
+
 /*
  * Extract compression ID from a varlena.
  *
@@ -293,6 +469,13 @@ CompressionNameToMethod(const char *compression)
 #endif
 		return TOAST_LZ4_COMPRESSION;
 	}
+	else if (strcmp(compression, "zstd") == 0)
+	{
+#ifndef USE_ZSTD
+		NO_COMPRESSION_SUPPORT("zstd");
+#endif
+		return TOAST_ZSTD_COMPRESSION;
+	}
 
 	return InvalidCompressionMethod;
 }
@@ -309,6 +492,8 @@ GetCompressionMethodName(char method)
 			return "pglz";
 		case TOAST_LZ4_COMPRESSION:
 			return "lz4";
+		case TOAST_ZSTD_COMPRESSION:
+			return "zstd";
 		default:
 			elog(ERROR, "invalid compression method %c", method);
 			return NULL;		/* keep compiler quiet */
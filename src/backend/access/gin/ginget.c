@@ -647,6 +647,60 @@ startScan(IndexScanDesc scan)
 		startScanKey(ginstate, so, so->keys + i);
 }
 
+/*
+ * Return the index of the first item in list[offset .. nlist - 1] that is
+ * greater than advancePast, or nlist if there is none.
+ *
+ * When one key in a multi-key query lets us skip ahead in another, many items
+ * of a loaded posting list can be known not to match.  Rather than stepping
+ * over them one at a time, gallop forward in exponentially growing steps and
+ * then binary search the last step, so that skipping k items costs
+ * O(log k) comparisons.  The common case of not skipping anything needs just
+ * one comparison.
+ */
+static inline int
+entryListSkip(ItemPointer list, int offset, int nlist,
+			  ItemPointer advancePast)
+{
+	int			lo;
+	int			hi;
+	int			step;
+
+	if (offset >= nlist ||
+		ginCompareItemPointers(&list[offset], advancePast) > 0)
+		return offset;
+
+	/* list[lo] <= advancePast; gallop until list[hi] > advancePast */
+	lo = offset;
+	step = 1;
+	for (;;)
+	{
+		hi = lo + step;
+		if (hi >= nlist)
+		{
+			hi = nlist;
+			break;
+		}
+		if (ginCompareItemPointers(&list[hi], advancePast) > 0)
+			break;
+		lo = hi;
+		step *= 2;
+	}
+
+	/* Now list[lo] <= advancePast, and list[hi] > advancePast if it exists */
+	while (hi - lo > 1)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (ginCompareItemPointers(&list[mid], advancePast) > 0)
+			hi = mid;
+		else
+			lo = mid;
+	}
+
+	return hi;
+}
+
 /*
  * Load the next batch of item pointers from a posting tree.
  *
@@ -772,22 +826,20 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 
 		entry->list = GinDataLeafPageGetItems(page, &entry->nlist, advancePast);
 
-		for (i = 0; i < entry->nlist; i++)
+		i = entryListSkip(entry->list, 0, entry->nlist, &advancePast);
+		if (i < entry->nlist)
 		{
-			if (ginCompareItemPointers(&advancePast, &entry->list[i]) < 0)
-			{
-				entry->offset = i;
+			entry->offset = i;
 
-				if (GinPageRightMost(page))
-				{
-					/* after processing the copied items, we're done. */
-					UnlockReleaseBuffer(entry->buffer);
-					entry->buffer = InvalidBuffer;
-				}
-				else
-					LockBuffer(entry->buffer, GIN_UNLOCK);
-				return;
+			if (GinPageRightMost(page))
+			{
+				/* after processing the copied items, we're done. */
+				UnlockReleaseBuffer(entry->buffer);
+				entry->buffer = InvalidBuffer;
 			}
+			else
+				LockBuffer(entry->buffer, GIN_UNLOCK);
+			return;
 		}
 	}
 }
@@ -926,6 +978,10 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		 */
 		for (;;)
 		{
+			/* Skip over any items <= advancePast */
+			entry->offset = entryListSkip(entry->list, entry->offset,
+										  entry->nlist, &advancePast);
+
 			if (entry->offset >= entry->nlist)
 			{
 				ItemPointerSetInvalid(&entry->curItem);
@@ -935,10 +991,6 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 
 			entry->curItem = entry->list[entry->offset++];
 
-			/* If we're not past advancePast, keep scanning */
-			if (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0)
-				continue;
-
 			/* Done unless we need to reduce the result */
 			if (!entry->reduceResult || !dropItem(entry))
 				break;
@@ -961,11 +1013,22 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 				}
 			}
 
-			entry->curItem = entry->list[entry->offset++];
+			/* Skip over any items <= advancePast */
+			entry->offset = entryListSkip(entry->list, entry->offset,
+										  entry->nlist, &advancePast);
 
-			/* If we're not past advancePast, keep scanning */
-			if (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0)
+			/*
+			 * If the whole batch was skipped, load more.  Remember the last
+			 * item, so that entryLoadMoreItems can tell whether to step right
+			 * or descend the tree again.
+			 */
+			if (entry->offset >= entry->nlist)
+			{
+				entry->curItem = entry->list[entry->nlist - 1];
 				continue;
+			}
+
+			entry->curItem = entry->list[entry->offset++];
 
 			/* Done unless we need to reduce the result */
 			if (!entry->reduceResult || !dropItem(entry))
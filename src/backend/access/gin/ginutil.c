@@ -67,6 +67,7 @@ ginhandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = ginbuild;
 	amroutine->ambuildempty = ginbuildempty;
+	amroutine->ambuildusesworkers = NULL;
 	amroutine->aminsert = gininsert;
 	amroutine->aminsertcleanup = NULL;
 	amroutine->ambulkdelete = ginbulkdelete;
@@ -16,9 +16,11 @@
 
 #include "access/gist_private.h"
 #include "access/gistscan.h"
+#include "access/tableam.h"
 #include "access/xloginsert.h"
 #include "catalog/pg_collation.h"
 #include "commands/vacuum.h"
+#include "common/int.h"
 #include "miscadmin.h"
 #include "nodes/execnodes.h"
 #include "storage/predicate.h"
@@ -40,6 +42,13 @@ static void gistfinishsplit(GISTInsertState *state, GISTInsertStack *stack,
 							GISTSTATE *giststate, List *splitinfo, bool unlockbuf);
 static void gistprunepage(Relation rel, Page page, Buffer buffer,
 						  Relation heapRel);
+static void gistbottomupdel(Relation rel, Page page, Buffer buffer,
+							Relation heapRel, IndexTuple newtup,
+							Size freespace);
+static void gistdeleteitems(Relation rel, Page page, Buffer buffer,
+							OffsetNumber *deletable, int ndeletable,
+							TransactionId snapshotConflictHorizon,
+							Relation heapRel);
 
 
 #define ROTATEDIST(d) do { \
@@ -78,7 +87,7 @@ gisthandler(PG_FUNCTION_ARGS)
 	amroutine->amclusterable = true;
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = false;
-	amroutine->amcanbuildparallel = false;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amcaninclude = true;
 	amroutine->amusemaintenanceworkmem = false;
 	amroutine->amsummarizing = false;
@@ -88,6 +97,7 @@ gisthandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = gistbuild;
 	amroutine->ambuildempty = gistbuildempty;
+	amroutine->ambuildusesworkers = gistbuildusesworkers;
 	amroutine->aminsert = gistinsert;
 	amroutine->aminsertcleanup = NULL;
 	amroutine->ambulkdelete = gistbulkdelete;
@@ -187,7 +197,7 @@ gistinsert(Relation r, Datum *values, bool *isnull,
 	itup = gistFormTuple(giststate, r, values, isnull, true);
 	itup->t_tid = *ht_ctid;
 
-	gistdoinsert(r, itup, 0, giststate, heapRel, false);
+	gistdoinsert(r, itup, 0, giststate, heapRel, false, indexUnchanged);
 
 	/* cleanup */
 	MemoryContextSwitchTo(oldCxt);
@@ -636,7 +646,8 @@ gistplacetopage(Relation rel, Size freespace, GISTSTATE *giststate,
  */
 void
 gistdoinsert(Relation r, IndexTuple itup, Size freespace,
-			 GISTSTATE *giststate, Relation heapRel, bool is_build)
+			 GISTSTATE *giststate, Relation heapRel, bool is_build,
+			 bool indexUnchanged)
 {
 	ItemId		iid;
 	IndexTuple	idxtuple;
@@ -650,6 +661,7 @@ gistdoinsert(Relation r, IndexTuple itup, Size freespace,
 	state.r = r;
 	state.heapRel = heapRel;
 	state.is_build = is_build;
+	state.indexUnchanged = indexUnchanged;
 
 	/* Start from the root */
 	firststack.blkno = GIST_ROOT_BLKNO;
@@ -1305,6 +1317,28 @@ gistinserttuples(GISTInsertState *state, GISTInsertStack *stack,
 	 */
 	CheckForSerializableConflictIn(state->r, NULL, BufferGetBlockNumber(stack->buffer));
 
+	/*
+	 * If a new leaf tuple left behind by an UPDATE that didn't change the
+	 * indexed value doesn't fit, try to avoid the page split by removing
+	 * index tuples that point to dead versions of rows.  LP_DEAD items are
+	 * cheaper to get rid of, so prune those first, as gistplacetopage()
+	 * would.
+	 */
+	if (state->indexUnchanged && ntup == 1 && oldoffnum == InvalidOffsetNumber)
+	{
+		Page		page = BufferGetPage(stack->buffer);
+
+		if (GistPageIsLeaf(page) && !GistFollowRight(page) &&
+			gistnospace(page, tuples, ntup, oldoffnum, state->freespace))
+		{
+			if (GistPageHasGarbage(page))
+				gistprunepage(state->r, page, stack->buffer, state->heapRel);
+			if (gistnospace(page, tuples, ntup, oldoffnum, state->freespace))
+				gistbottomupdel(state->r, page, stack->buffer,
+								state->heapRel, tuples[0], state->freespace);
+		}
+	}
+
 	/* Insert the tuple(s) to the page, splitting the page if necessary */
 	is_split = gistplacetopage(state->r, state->freespace, giststate,
 							   stack->buffer,
@@ -1704,43 +1738,204 @@ gistprunepage(Relation rel, Page page, Buffer buffer, Relation heapRel)
 				index_compute_xid_horizon_for_tuples(rel, heapRel, buffer,
 													 deletable, ndeletable);
 
-		START_CRIT_SECTION();
+		gistdeleteitems(rel, page, buffer, deletable, ndeletable,
+						snapshotConflictHorizon, heapRel);
+	}
 
-		PageIndexMultiDelete(page, deletable, ndeletable);
+	/*
+	 * Note: if we didn't find any LP_DEAD items, then the page's
+	 * F_HAS_GARBAGE hint bit is falsely set.  We do not bother expending a
+	 * separate write to clear it, however.  We will clear it when we split
+	 * the page.
+	 */
+}
 
-		/*
-		 * Mark the page as not containing any LP_DEAD items.  This is not
-		 * certainly true (there might be some that have recently been marked,
-		 * but weren't included in our target-item list), but it will almost
-		 * always be true and it doesn't seem worth an additional page scan to
-		 * check it. Remember that F_HAS_GARBAGE is only a hint anyway.
-		 */
-		GistClearPageHasGarbage(page);
+/* Leaf tuple and its offset, for finding duplicates in gistbottomupdel() */
+typedef struct GISTBottomUpItem
+{
+	OffsetNumber offnum;
+	IndexTuple	itup;
+} GISTBottomUpItem;
 
-		MarkBufferDirty(buffer);
+/*
+ * Do two leaf tuples store the same key?  Versions of a row whose indexed
+ * value didn't change produce the same compressed key, so comparing the
+ * tuples' bytes (after the heap TID) is enough to detect them.
+ */
+static int
+gistbottomupcmp(IndexTuple a, IndexTuple b)
+{
+	Size		asize = IndexTupleSize(a);
+	Size		bsize = IndexTupleSize(b);
 
-		/* XLOG stuff */
-		if (RelationNeedsWAL(rel))
-		{
-			XLogRecPtr	recptr;
+	if (asize != bsize)
+		return asize < bsize ? -1 : 1;
 
-			recptr = gistXLogDelete(buffer,
-									deletable, ndeletable,
-									snapshotConflictHorizon,
-									heapRel);
+	return memcmp((char *) a + sizeof(ItemPointerData),
+				  (char *) b + sizeof(ItemPointerData),
+				  asize - sizeof(ItemPointerData));
+}
 
-			PageSetLSN(page, recptr);
-		}
-		else
-			PageSetLSN(page, gistGetFakeLSN(rel));
+static int
+gistbottomupitemcmp(const void *a, const void *b)
+{
+	const GISTBottomUpItem *ia = (const GISTBottomUpItem *) a;
+	const GISTBottomUpItem *ib = (const GISTBottomUpItem *) b;
+	int			cmp;
+
+	cmp = gistbottomupcmp(ia->itup, ib->itup);
+	if (cmp != 0)
+		return cmp;
+	return pg_cmp_u16(ia->offnum, ib->offnum);
+}
+
+/*
+ * gistbottomupdel() -- try bottom-up deletion on a full leaf page.
+ *
+ * This is the GiST version of nbtree's _bt_bottomupdel_pass().  It is used
+ * when a tuple produced by an UPDATE that didn't change the indexed value
+ * doesn't fit on a leaf page.  All the TIDs on the page are passed to the
+ * tableam, which decides which of them are worth checking.  Since GiST leaf
+ * pages aren't ordered, we find duplicates by sorting the tuples, and mark
+ * the duplicates, as well as copies of newtup's key, as promising.
+ */
+static void
+gistbottomupdel(Relation rel, Page page, Buffer buffer, Relation heapRel,
+				IndexTuple newtup, Size freespace)
+{
+	TM_IndexDeleteOp delstate;
+	TransactionId snapshotConflictHorizon;
+	GISTBottomUpItem *items;
+	bool		isdeletable[MaxIndexTuplesPerPage + 1];
+	OffsetNumber deletable[MaxIndexTuplesPerPage];
+	int			ndeletable = 0;
+	OffsetNumber offnum,
+				maxoff;
+	int			nitems = 0;
+	Size		newitemsz;
+
+	Assert(GistPageIsLeaf(page));
+
+	maxoff = PageGetMaxOffsetNumber(page);
+	if (maxoff < FirstOffsetNumber)
+		return;
 
-		END_CRIT_SECTION();
+	items = palloc(maxoff * sizeof(GISTBottomUpItem));
+	for (offnum = FirstOffsetNumber;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+
+		items[nitems].offnum = offnum;
+		items[nitems].itup = (IndexTuple) PageGetItem(page, itemid);
+		nitems++;
+	}
+	qsort(items, nitems, sizeof(GISTBottomUpItem), gistbottomupitemcmp);
+
+	newitemsz = IndexTupleSize(newtup) + sizeof(ItemIdData) + freespace;
+	delstate.irel = rel;
+	delstate.iblknum = BufferGetBlockNumber(buffer);
+	delstate.bottomup = true;
+	delstate.bottomupfreespace = Max(BLCKSZ / 16, newitemsz);
+	delstate.ndeltids = 0;
+	delstate.deltids = palloc(nitems * sizeof(TM_IndexDelete));
+	delstate.status = palloc(nitems * sizeof(TM_IndexStatus));
+
+	for (int i = 0; i < nitems; i++)
+	{
+		IndexTuple	itup = items[i].itup;
+		ItemId		itemid = PageGetItemId(page, items[i].offnum);
+		TM_IndexDelete *ideltid = &delstate.deltids[delstate.ndeltids];
+		TM_IndexStatus *istatus = &delstate.status[delstate.ndeltids];
+		bool		promising;
+
+		promising = ((i > 0 && gistbottomupcmp(items[i - 1].itup, itup) == 0) ||
+					 (i < nitems - 1 &&
+					  gistbottomupcmp(items[i + 1].itup, itup) == 0) ||
+					 gistbottomupcmp(newtup, itup) == 0);
+
+		ideltid->tid = itup->t_tid;
+		ideltid->id = delstate.ndeltids;
+		istatus->idxoffnum = items[i].offnum;
+		istatus->knowndeletable = false;	/* for now */
+		istatus->promising = promising;
+		istatus->freespace = ItemIdGetLength(itemid) + sizeof(ItemIdData);
+
+		delstate.ndeltids++;
 	}
+	pfree(items);
+
+	/* Ask tableam which TIDs are deletable */
+	snapshotConflictHorizon = table_index_delete_tuples(heapRel, &delstate);
+
+	/* Should not WAL-log snapshotConflictHorizon unless it's required */
+	if (!XLogStandbyInfoActive())
+		snapshotConflictHorizon = InvalidTransactionId;
+
+	/* Map the result back onto page offsets, in ascending order */
+	memset(isdeletable, 0, sizeof(isdeletable));
+	for (int i = 0; i < delstate.ndeltids; i++)
+	{
+		TM_IndexStatus *dstatus = &delstate.status[delstate.deltids[i].id];
+
+		if (dstatus->knowndeletable)
+			isdeletable[dstatus->idxoffnum] = true;
+	}
+	pfree(delstate.deltids);
+	pfree(delstate.status);
+
+	for (offnum = FirstOffsetNumber;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		if (isdeletable[offnum])
+			deletable[ndeletable++] = offnum;
+	}
+
+	if (ndeletable > 0)
+		gistdeleteitems(rel, page, buffer, deletable, ndeletable,
+						snapshotConflictHorizon, heapRel);
+}
+
+/*
+ * gistdeleteitems() -- physically delete items from a leaf page, and
+ * WAL-log that.  Used by both gistprunepage() and gistbottomupdel().
+ */
+static void
+gistdeleteitems(Relation rel, Page page, Buffer buffer,
+				OffsetNumber *deletable, int ndeletable,
+				TransactionId snapshotConflictHorizon, Relation heapRel)
+{
+	START_CRIT_SECTION();
+
+	PageIndexMultiDelete(page, deletable, ndeletable);
 
 	/*
-	 * Note: if we didn't find any LP_DEAD items, then the page's
-	 * F_HAS_GARBAGE hint bit is falsely set.  We do not bother expending a
-	 * separate write to clear it, however.  We will clear it when we split
-	 * the page.
+	 * Mark the page as not containing any LP_DEAD items.  This is not
+	 * certainly true (there might be some that have recently been marked,
+	 * but weren't included in our target-item list), but it will almost
+	 * always be true and it doesn't seem worth an additional page scan to
+	 * check it. Remember that F_HAS_GARBAGE is only a hint anyway.
 	 */
+	GistClearPageHasGarbage(page);
+
+	MarkBufferDirty(buffer);
+
+	/* XLOG stuff */
+	if (RelationNeedsWAL(rel))
+	{
+		XLogRecPtr	recptr;
+
+		recptr = gistXLogDelete(buffer,
+								deletable, ndeletable,
+								snapshotConflictHorizon,
+								heapRel);
+
+		PageSetLSN(page, recptr);
+	}
+	else
+		PageSetLSN(page, gistGetFakeLSN(rel));
+
+	END_CRIT_SECTION();
 }
@@ -36,6 +36,7 @@
 
 #include "access/genam.h"
 #include "access/gist_private.h"
+#include "access/parallelbuild.h"
 #include "access/tableam.h"
 #include "access/xloginsert.h"
 #include "miscadmin.h"
@@ -78,7 +79,12 @@ typedef enum
 	GIST_BUFFERING_ACTIVE,		/* in buffering build mode */
 } GistBuildMode;
 
-/* Working state for gistbuild and its callback */
+/*
+ * Working state for gistbuild and its callback.
+ *
+ * When a parallel sorted build is performed, there is a GISTBuildState for
+ * each participant.
+ */
 typedef struct
 {
 	Relation	indexrel;
@@ -108,6 +114,12 @@ typedef struct
 	BlockNumber pages_allocated;
 
 	BulkWriteState *bulkstate;
+
+	/*
+	 * leader is only present when a parallel index build is performed, and
+	 * only in the leader process.
+	 */
+	ParallelBuildLeader *leader;
 } GISTBuildState;
 
 #define GIST_SORTED_BUILD_PAGE_NUM 4
@@ -164,6 +176,14 @@ static void gistProcessEmptyingQueue(GISTBuildState *buildstate);
 static void gistEmptyAllBuffers(GISTBuildState *buildstate);
 static int	gistGetMaxLevel(Relation index);
 
+static GistBuildMode gistChooseBuildMode(Relation index);
+static void _gist_leader_participate_as_worker(ParallelBuildLeader *leader,
+											   void *arg);
+static void _gist_parallel_scan_and_sort(ParallelBuildShared *shared,
+										 Relation heap, Relation index,
+										 Sharedsort *sharedsort, int sortmem,
+										 bool progress);
+
 static void gistInitParentMap(GISTBuildState *buildstate);
 static void gistMemorizeParent(GISTBuildState *buildstate, BlockNumber child,
 							   BlockNumber parent);
@@ -183,7 +203,6 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	GISTBuildState buildstate;
 	MemoryContext oldcxt = CurrentMemoryContext;
 	int			fillfactor;
-	Oid			SortSupportFnOids[INDEX_MAX_KEYS];
 	GiSTOptions *options = (GiSTOptions *) index->rd_options;
 
 	/*
@@ -197,6 +216,7 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.indexrel = index;
 	buildstate.heaprel = heap;
 	buildstate.sortstate = NULL;
+	buildstate.leader = NULL;
 	buildstate.giststate = initGISTstate(index);
 
 	/*
@@ -206,46 +226,8 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	 */
 	buildstate.giststate->tempCxt = createTempGistContext();
 
-	/*
-	 * Choose build strategy.  First check whether the user specified to use
-	 * buffering mode.  (The use-case for that in the field is somewhat
-	 * questionable perhaps, but it's important for testing purposes.)
-	 */
-	if (options)
-	{
-		if (options->buffering_mode == GIST_OPTION_BUFFERING_ON)
-			buildstate.buildMode = GIST_BUFFERING_STATS;
-		else if (options->buffering_mode == GIST_OPTION_BUFFERING_OFF)
-			buildstate.buildMode = GIST_BUFFERING_DISABLED;
-		else					/* must be "auto" */
-			buildstate.buildMode = GIST_BUFFERING_AUTO;
-	}
-	else
-	{
-		buildstate.buildMode = GIST_BUFFERING_AUTO;
-	}
-
-	/*
-	 * Unless buffering mode was forced, see if we can use sorting instead.
-	 */
-	if (buildstate.buildMode != GIST_BUFFERING_STATS)
-	{
-		bool		hasallsortsupports = true;
-		int			keyscount = IndexRelationGetNumberOfKeyAttributes(index);
-
-		for (int i = 0; i < keyscount; i++)
-		{
-			SortSupportFnOids[i] = index_getprocid(index, i + 1,
-												   GIST_SORTSUPPORT_PROC);
-			if (!OidIsValid(SortSupportFnOids[i]))
-			{
-				hasallsortsupports = false;
-				break;
-			}
-		}
-		if (hasallsortsupports)
-			buildstate.buildMode = GIST_SORTED_BUILD;
-	}
+	/* Choose build strategy */
+	buildstate.buildMode = gistChooseBuildMode(index);
 
 	/*
 	 * Calculate target amount of free space to leave on pages.
@@ -261,19 +243,48 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 
 	if (buildstate.buildMode == GIST_SORTED_BUILD)
 	{
+		SortCoordinate coordinate = NULL;
+
+		/*
+		 * Attempt to launch parallel worker scan when required.  Workers
+		 * (and the leader, acting as a worker) each sort a part of the
+		 * table, leaving the final merge to the leader's tuplesort below.
+		 */
+		if (indexInfo->ii_ParallelWorkers > 0)
+			buildstate.leader =
+				parallel_build_begin("_gist_parallel_build_main",
+									 heap, index, indexInfo->ii_Concurrent,
+									 indexInfo->ii_ParallelWorkers, 1,
+									 NULL, 0,
+									 _gist_leader_participate_as_worker,
+									 &buildstate);
+
+		if (buildstate.leader)
+			coordinate = parallel_build_leader_coordinate(buildstate.leader, 0);
+
 		/*
 		 * Sort all data, build the index from bottom up.
 		 */
 		buildstate.sortstate = tuplesort_begin_index_gist(heap,
 														  index,
 														  maintenance_work_mem,
-														  NULL,
+														  coordinate,
 														  TUPLESORT_NONE);
 
 		/* Scan the table, adding all tuples to the tuplesort */
-		reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
-										   gistSortedBuildCallback,
-										   &buildstate, NULL);
+		if (!buildstate.leader)
+			reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
+											   gistSortedBuildCallback,
+											   &buildstate, NULL);
+		else
+		{
+			double		indtuples;
+
+			reltuples = parallel_build_wait_scan(buildstate.leader,
+												 &indtuples, NULL,
+												 &indexInfo->ii_BrokenHotChain);
+			buildstate.indtuples = (int64) indtuples;
+		}
 
 		/*
 		 * Perform the sort and build index pages.
@@ -283,12 +294,18 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 		gist_indexsortbuild(&buildstate);
 
 		tuplesort_end(buildstate.sortstate);
+
+		/* Shut down leader (and its workers), if parallel */
+		if (buildstate.leader)
+			parallel_build_end(buildstate.leader);
 	}
 	else
 	{
 		/*
 		 * Initialize an empty index and insert all tuples, possibly using
-		 * buffers on intermediate levels.
+		 * buffers on intermediate levels.  This is always done serially
+		 * (gistbuildusesworkers() keeps the planner from asking for any
+		 * workers).
 		 */
 		Buffer		buffer;
 		Page		page;
@@ -354,6 +371,51 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	return result;
 }
 
+/*
+ * Choose the strategy used to build the index.
+ */
+static GistBuildMode
+gistChooseBuildMode(Relation index)
+{
+	GiSTOptions *options = (GiSTOptions *) index->rd_options;
+	int			keyscount = IndexRelationGetNumberOfKeyAttributes(index);
+
+	/*
+	 * First check whether the user specified to use buffering mode.  (The
+	 * use-case for that in the field is somewhat questionable perhaps, but
+	 * it's important for testing purposes.)
+	 */
+	if (options && options->buffering_mode == GIST_OPTION_BUFFERING_ON)
+		return GIST_BUFFERING_STATS;
+
+	/*
+	 * Unless buffering mode was forced, see if we can use sorting instead.
+	 */
+	for (int i = 0; i < keyscount; i++)
+	{
+		if (!OidIsValid(index_getprocid(index, i + 1, GIST_SORTSUPPORT_PROC)))
+		{
+			if (options && options->buffering_mode == GIST_OPTION_BUFFERING_OFF)
+				return GIST_BUFFERING_DISABLED;
+			else				/* must be "auto" */
+				return GIST_BUFFERING_AUTO;
+		}
+	}
+
+	return GIST_SORTED_BUILD;
+}
+
+/*
+ * Will a parallel build of this index make use of parallel workers?
+ *
+ * Only the sorted build strategy is parallelized.
+ */
+bool
+gistbuildusesworkers(Relation heap, Relation index)
+{
+	return gistChooseBuildMode(index) == GIST_SORTED_BUILD;
+}
+
 /*-------------------------------------------------------------------------
  * Routines for sorted build
  *-------------------------------------------------------------------------
@@ -609,6 +671,119 @@ gist_indexsortbuild_levelstate_flush(GISTBuildState *state,
 }
 
 
+/*-------------------------------------------------------------------------
+ * Routines for parallel sorted build
+ *
+ * Each participant scans part of the table and sorts its own tuples, and the
+ * leader merges the sorted runs and builds the index bottom-up, just like a
+ * serial sorted build does.  The parallel context and shared state are set
+ * up by parallelbuild.c.
+ *-------------------------------------------------------------------------
+ */
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_gist_leader_participate_as_worker(ParallelBuildLeader *leader, void *arg)
+{
+	GISTBuildState *buildstate = (GISTBuildState *) arg;
+	int			sortmem;
+
+	/*
+	 * Might as well use reliable figure when doling out maintenance_work_mem
+	 * (when requested number of workers were not launched, this will be
+	 * somewhat higher than it is for other workers).
+	 */
+	sortmem = maintenance_work_mem / leader->nparticipanttuplesorts;
+
+	/* Perform work common to all participants */
+	_gist_parallel_scan_and_sort(leader->shared, buildstate->heaprel,
+								 buildstate->indexrel, leader->sharedsort[0],
+								 sortmem, true);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_gist_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelBuildShared *shared;
+	Sharedsort *sharedsort[PARALLEL_BUILD_MAX_SORTS];
+	Relation	heapRel;
+	Relation	indexRel;
+	int			sortmem;
+
+	shared = parallel_build_worker_begin(seg, toc, &heapRel, &indexRel,
+										 sharedsort);
+
+	/* Perform this worker's share of the scan and sort */
+	sortmem = maintenance_work_mem / shared->scantuplesortstates;
+	_gist_parallel_scan_and_sort(shared, heapRel, indexRel, sharedsort[0],
+								 sortmem, false);
+
+	parallel_build_worker_end(toc, shared, heapRel, indexRel);
+}
+
+/*
+ * Perform a worker's portion of a parallel sorted build.
+ *
+ * This sets up a private GISTBuildState (with its own GISTSTATE, needed to
+ * compress the values), scans the participant's share of the table, and
+ * sorts the resulting tuples into a "partial" tuplesort that the leader
+ * will later merge.
+ *
+ * sortmem is the amount of working memory to use within each worker,
+ * expressed in KBs.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_gist_parallel_scan_and_sort(ParallelBuildShared *shared,
+							 Relation heap, Relation index,
+							 Sharedsort *sharedsort, int sortmem,
+							 bool progress)
+{
+	GISTBuildState buildstate;
+	double		reltuples;
+	bool		brokenhotchain;
+
+	/* Fill in buildstate for gistSortedBuildCallback() */
+	memset(&buildstate, 0, sizeof(buildstate));
+	buildstate.indexrel = index;
+	buildstate.heaprel = heap;
+	buildstate.buildMode = GIST_SORTED_BUILD;
+	buildstate.indtuples = 0;
+	buildstate.leader = NULL;
+	buildstate.giststate = initGISTstate(index);
+	buildstate.giststate->tempCxt = createTempGistContext();
+
+	/* Begin "partial" tuplesort */
+	buildstate.sortstate =
+		tuplesort_begin_index_gist(heap, index, sortmem,
+								   parallel_build_worker_coordinate(sharedsort),
+								   TUPLESORT_NONE);
+
+	/* Join parallel scan */
+	reltuples = parallel_build_scan(shared, heap, index, progress,
+									gistSortedBuildCallback, &buildstate,
+									&brokenhotchain);
+
+	/* Execute this worker's part of the sort */
+	tuplesort_performsort(buildstate.sortstate);
+
+	/* Done.  Record ambuild statistics, and let the leader know. */
+	parallel_build_scan_done(shared, reltuples, (double) buildstate.indtuples,
+							 false, brokenhotchain);
+
+	/* We can end tuplesorts immediately */
+	tuplesort_end(buildstate.sortstate);
+
+	MemoryContextDelete(buildstate.giststate->tempCxt);
+	freeGISTstate(buildstate.giststate);
+}
+
 /*-------------------------------------------------------------------------
  * Routines for non-sorted build
  *-------------------------------------------------------------------------
@@ -863,7 +1038,8 @@ gistBuildCallback(Relation index,
 		 * locked, we call gistdoinsert directly.
 		 */
 		gistdoinsert(index, itup, buildstate->freespace,
-					 buildstate->giststate, buildstate->heaprel, true);
+					 buildstate->giststate, buildstate->heaprel, true,
+					 false);
 	}
 
 	MemoryContextSwitchTo(oldCtx);
@@ -42,6 +42,7 @@ typedef struct
 	Relation	heapRel;		/* heap relation descriptor */
 } HashBuildState;
 
+static Size hashbuildsortthreshold(Relation index);
 static void hashbuildCallback(Relation index,
 							  ItemPointer tid,
 							  Datum *values,
@@ -77,7 +78,7 @@ hashhandler(PG_FUNCTION_ARGS)
 	amroutine->amclusterable = false;
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = false;
-	amroutine->amcanbuildparallel = false;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amcaninclude = false;
 	amroutine->amusemaintenanceworkmem = false;
 	amroutine->amsummarizing = false;
@@ -87,6 +88,7 @@ hashhandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = hashbuild;
 	amroutine->ambuildempty = hashbuildempty;
+	amroutine->ambuildusesworkers = hashbuildusesworkers;
 	amroutine->aminsert = hashinsert;
 	amroutine->aminsertcleanup = NULL;
 	amroutine->ambulkdelete = hashbulkdelete;
@@ -126,7 +128,6 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	double		reltuples;
 	double		allvisfrac;
 	uint32		num_buckets;
-	Size		sort_threshold;
 	HashBuildState buildstate;
 
 	/*
@@ -144,31 +145,13 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	num_buckets = _hash_init(index, reltuples, MAIN_FORKNUM);
 
 	/*
-	 * If we just insert the tuples into the index in scan order, then
-	 * (assuming their hash codes are pretty random) there will be no locality
-	 * of access to the index, and if the index is bigger than available RAM
-	 * then we'll thrash horribly.  To prevent that scenario, we can sort the
-	 * tuples by (expected) bucket number.  However, such a sort is useless
-	 * overhead when the index does fit in RAM.  We choose to sort if the
-	 * initial index size exceeds maintenance_work_mem, or the number of
-	 * buffers usable for the index, whichever is less.  (Limiting by the
-	 * number of buffers should reduce thrashing between PG buffers and kernel
-	 * buffers, which seems useful even if no physical I/O results.  Limiting
-	 * by maintenance_work_mem is useful to allow easy testing of the sort
-	 * code path, and may be useful to DBAs as an additional control knob.)
-	 *
-	 * NOTE: this test will need adjustment if a bucket is ever different from
-	 * one page.  Also, "initial index size" accounting does not include the
-	 * metapage, nor the first bitmap page.
+	 * Sort the tuples by (expected) bucket number if the index is large;
+	 * see hashbuildsortthreshold().
 	 */
-	sort_threshold = (maintenance_work_mem * (Size) 1024) / BLCKSZ;
-	if (index->rd_rel->relpersistence != RELPERSISTENCE_TEMP)
-		sort_threshold = Min(sort_threshold, NBuffers);
-	else
-		sort_threshold = Min(sort_threshold, NLocBuffer);
-
-	if (num_buckets >= sort_threshold)
-		buildstate.spool = _h_spoolinit(heap, index, num_buckets);
+	if (num_buckets >= hashbuildsortthreshold(index))
+		buildstate.spool = _h_spoolinit(heap, index, num_buckets,
+										indexInfo->ii_Concurrent,
+										indexInfo->ii_ParallelWorkers);
 	else
 		buildstate.spool = NULL;
 
@@ -176,10 +159,15 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.indtuples = 0;
 	buildstate.heapRel = heap;
 
-	/* do the heap scan */
-	reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
-									   hashbuildCallback,
-									   &buildstate, NULL);
+	/* do the heap scan, unless parallel workers are doing it for us */
+	if (buildstate.spool == NULL || !_h_spoolisparallel(buildstate.spool))
+		reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
+										   hashbuildCallback,
+										   &buildstate, NULL);
+	else
+		reltuples = _h_parallel_heapscan(buildstate.spool,
+										 &indexInfo->ii_BrokenHotChain,
+										 &buildstate.indtuples);
 	pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_TOTAL,
 								 buildstate.indtuples);
 
@@ -201,6 +189,61 @@ hashbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	return result;
 }
 
+/*
+ * Number of initial buckets above which hashbuild() sorts the tuples.
+ *
+ * If we just insert the tuples into the index in scan order, then (assuming
+ * their hash codes are pretty random) there will be no locality of access to
+ * the index, and if the index is bigger than available RAM then we'll thrash
+ * horribly.  To prevent that scenario, we can sort the tuples by (expected)
+ * bucket number.  However, such a sort is useless overhead when the index
+ * does fit in RAM.  We choose to sort if the initial index size exceeds
+ * maintenance_work_mem, or the number of buffers usable for the index,
+ * whichever is less.  (Limiting by the number of buffers should reduce
+ * thrashing between PG buffers and kernel buffers, which seems useful even if
+ * no physical I/O results.  Limiting by maintenance_work_mem is useful to
+ * allow easy testing of the sort code path, and may be useful to DBAs as an
+ * additional control knob.)
+ *
+ * NOTE: this test will need adjustment if a bucket is ever different from
+ * one page.  Also, "initial index size" accounting does not include the
+ * metapage, nor the first bitmap page.
+ */
+static Size
+hashbuildsortthreshold(Relation index)
+{
+	Size		sort_threshold;
+
+	sort_threshold = (maintenance_work_mem * (Size) 1024) / BLCKSZ;
+	if (index->rd_rel->relpersistence != RELPERSISTENCE_TEMP)
+		sort_threshold = Min(sort_threshold, NBuffers);
+	else
+		sort_threshold = Min(sort_threshold, NLocBuffer);
+
+	return sort_threshold;
+}
+
+/*
+ *	hashbuildusesworkers() -- will a parallel build use parallel workers?
+ *
+ * Only the sorting path can make use of parallel workers: they scan the heap
+ * and sort the tuples, leaving the insertions to the leader.  If the index is
+ * small enough not to need sorting, the build is serial.
+ */
+bool
+hashbuildusesworkers(Relation heap, Relation index)
+{
+	BlockNumber relpages;
+	double		reltuples;
+	double		allvisfrac;
+
+	/* Make the same estimate as hashbuild() */
+	estimate_rel_size(heap, NULL, &relpages, &reltuples, &allvisfrac);
+
+	return _hash_estimate_num_buckets(index, reltuples) >=
+		hashbuildsortthreshold(index);
+}
+
 /*
  *	hashbuildempty() -- build an empty hash index in the initialization fork
  */
@@ -241,7 +284,7 @@ hashbuildCallback(Relation index,
 		itup = index_form_tuple(RelationGetDescr(index),
 								index_values, index_isnull);
 		itup->t_tid = *tid;
-		_hash_doinsert(index, itup, buildstate->heapRel, false);
+		_hash_doinsert(index, itup, buildstate->heapRel, false, false);
 		pfree(itup);
 	}
 
@@ -275,7 +318,7 @@ hashinsert(Relation rel, Datum *values, bool *isnull,
 	itup = index_form_tuple(RelationGetDescr(rel), index_values, index_isnull);
 	itup->t_tid = *ht_ctid;
 
-	_hash_doinsert(rel, itup, heapRel, false);
+	_hash_doinsert(rel, itup, heapRel, false, indexUnchanged);
 
 	pfree(itup);
 
@@ -17,6 +17,7 @@
 
 #include "access/hash.h"
 #include "access/hash_xlog.h"
+#include "access/tableam.h"
 #include "access/xloginsert.h"
 #include "miscadmin.h"
 #include "storage/predicate.h"
@@ -24,6 +25,12 @@
 
 static void _hash_vacuum_one_page(Relation rel, Relation hrel,
 								  Buffer metabuf, Buffer buf);
+static void _hash_bottomupdel_pass(Relation rel, Relation hrel,
+								   Buffer metabuf, Buffer buf, Size itemsz);
+static void _hash_delitems(Relation rel, Relation hrel,
+						   Buffer metabuf, Buffer buf,
+						   OffsetNumber *deletable, int ndeletable,
+						   TransactionId snapshotConflictHorizon);
 
 /*
  *	_hash_doinsert() -- Handle insertion of a single index tuple.
@@ -33,9 +40,14 @@ static void _hash_vacuum_one_page(Relation rel, Relation hrel,
  *
  * 'sorted' must only be passed as 'true' when inserts are done in hashkey
  * order.
+ *
+ * 'indexUnchanged' is the executor's hint that the tuple is a new version
+ * of a row whose indexed value wasn't changed by an UPDATE; it enables a
+ * bottom-up deletion pass before we add an overflow page to the bucket.
  */
 void
-_hash_doinsert(Relation rel, IndexTuple itup, Relation heapRel, bool sorted)
+_hash_doinsert(Relation rel, IndexTuple itup, Relation heapRel, bool sorted,
+			   bool indexUnchanged)
 {
 	Buffer		buf = InvalidBuffer;
 	Buffer		bucket_buf;
@@ -171,7 +183,21 @@ restart_insert:
 		{
 			/*
 			 * we're at the end of the bucket chain and we haven't found a
-			 * page with enough room.  allocate a new overflow page.
+			 * page with enough room.  If the incoming tuple is a duplicate
+			 * left behind by an UPDATE, try to make room on the last page by
+			 * deleting older versions that are no longer visible to anyone,
+			 * before growing the chain.
+			 */
+			if (indexUnchanged && IsBufferCleanupOK(buf))
+			{
+				_hash_bottomupdel_pass(rel, heapRel, metabuf, buf, itemsz);
+
+				if (PageGetFreeSpace(page) >= itemsz)
+					break;		/* OK, now we have enough space */
+			}
+
+			/*
+			 * still no room.  allocate a new overflow page.
 			 */
 
 			/* release our write lock without modifying buffer */
@@ -370,8 +396,6 @@ _hash_vacuum_one_page(Relation rel, Relation hrel, Buffer metabuf, Buffer buf)
 	OffsetNumber offnum,
 				maxoff;
 	Page		page = BufferGetPage(buf);
-	HashPageOpaque pageopaque;
-	HashMetaPage metap;
 
 	/* Scan each tuple in page to see if it is marked as LP_DEAD */
 	maxoff = PageGetMaxOffsetNumber(page);
@@ -393,69 +417,200 @@ _hash_vacuum_one_page(Relation rel, Relation hrel, Buffer metabuf, Buffer buf)
 			index_compute_xid_horizon_for_tuples(rel, hrel, buf,
 												 deletable, ndeletable);
 
-		/*
-		 * Write-lock the meta page so that we can decrement tuple count.
-		 */
-		LockBuffer(metabuf, BUFFER_LOCK_EXCLUSIVE);
+		_hash_delitems(rel, hrel, metabuf, buf, deletable, ndeletable,
+					   snapshotConflictHorizon);
+	}
+}
 
-		/* No ereport(ERROR) until changes are logged */
-		START_CRIT_SECTION();
+/*
+ * _hash_bottomupdel_pass - try bottom-up deletion on just one index page.
+ *
+ * This is the hash index counterpart of nbtree's _bt_bottomupdel_pass().  It
+ * is called when an insertion made by an UPDATE that did not change the
+ * indexed value would otherwise have to add an overflow page.  Such UPDATEs
+ * leave behind runs of index tuples with the same hash key that point to
+ * older versions of the same logical rows, which we mark as promising.  We
+ * pass every TID on the page to the tableam, which decides how many of them
+ * are worth checking, and then delete whatever it found to be deletable.
+ *
+ * We must acquire cleanup lock on the page being modified before calling
+ * this function, as with _hash_vacuum_one_page().
+ */
+static void
+_hash_bottomupdel_pass(Relation rel, Relation hrel, Buffer metabuf,
+					   Buffer buf, Size itemsz)
+{
+	Page		page = BufferGetPage(buf);
+	TM_IndexDeleteOp delstate;
+	TransactionId snapshotConflictHorizon;
+	bool		isdeletable[MaxIndexTuplesPerPage + 1];
+	OffsetNumber deletable[MaxIndexTuplesPerPage];
+	int			ndeletable = 0;
+	OffsetNumber offnum,
+				maxoff;
+	uint32		prevhashkey = 0;
 
-		PageIndexMultiDelete(page, deletable, ndeletable);
+	maxoff = PageGetMaxOffsetNumber(page);
+	if (maxoff < FirstOffsetNumber)
+		return;
+
+	/* Passed-in itemsz is MAXALIGNED but does not include line pointer */
+	delstate.irel = rel;
+	delstate.iblknum = BufferGetBlockNumber(buf);
+	delstate.bottomup = true;
+	delstate.bottomupfreespace = Max(BLCKSZ / 16, itemsz + sizeof(ItemIdData));
+	delstate.ndeltids = 0;
+	delstate.deltids = palloc(maxoff * sizeof(TM_IndexDelete));
+	delstate.status = palloc(maxoff * sizeof(TM_IndexStatus));
 
-		/*
-		 * Mark the page as not containing any LP_DEAD items. This is not
-		 * certainly true (there might be some that have recently been marked,
-		 * but weren't included in our target-item list), but it will almost
-		 * always be true and it doesn't seem worth an additional page scan to
-		 * check it. Remember that LH_PAGE_HAS_DEAD_TUPLES is only a hint
-		 * anyway.
-		 */
-		pageopaque = HashPageGetOpaque(page);
-		pageopaque->hasho_flag &= ~LH_PAGE_HAS_DEAD_TUPLES;
+	/*
+	 * Tuples are kept in hash key order, so a tuple is a duplicate (and so
+	 * promising) when either of its neighbors has the same hash key.
+	 */
+	for (offnum = FirstOffsetNumber;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	itup = (IndexTuple) PageGetItem(page, itemid);
+		uint32		hashkey = _hash_get_indextuple_hashkey(itup);
+		TM_IndexDelete *ideltid = &delstate.deltids[delstate.ndeltids];
+		TM_IndexStatus *istatus = &delstate.status[delstate.ndeltids];
+		bool		promising = false;
 
-		metap = HashPageGetMeta(BufferGetPage(metabuf));
-		metap->hashm_ntuples -= ndeletable;
+		if (offnum > FirstOffsetNumber && hashkey == prevhashkey)
+			promising = true;
+		else if (offnum < maxoff)
+		{
+			ItemId		nextitemid = PageGetItemId(page,
+												   OffsetNumberNext(offnum));
+			IndexTuple	nextitup = (IndexTuple) PageGetItem(page, nextitemid);
 
-		MarkBufferDirty(buf);
-		MarkBufferDirty(metabuf);
+			promising = (_hash_get_indextuple_hashkey(nextitup) == hashkey);
+		}
+		prevhashkey = hashkey;
 
-		/* XLOG stuff */
-		if (RelationNeedsWAL(rel))
-		{
-			xl_hash_vacuum_one_page xlrec;
-			XLogRecPtr	recptr;
+		ideltid->tid = itup->t_tid;
+		ideltid->id = delstate.ndeltids;
+		istatus->idxoffnum = offnum;
+		istatus->knowndeletable = false;	/* for now */
+		istatus->promising = promising;
+		istatus->freespace = ItemIdGetLength(itemid) + sizeof(ItemIdData);
 
-			xlrec.isCatalogRel = RelationIsAccessibleInLogicalDecoding(hrel);
-			xlrec.snapshotConflictHorizon = snapshotConflictHorizon;
-			xlrec.ntuples = ndeletable;
+		delstate.ndeltids++;
+	}
 
-			XLogBeginInsert();
-			XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
-			XLogRegisterData(&xlrec, SizeOfHashVacuumOnePage);
+	/* Ask tableam which TIDs are deletable */
+	snapshotConflictHorizon = table_index_delete_tuples(hrel, &delstate);
 
-			/*
-			 * We need the target-offsets array whether or not we store the
-			 * whole buffer, to allow us to find the snapshotConflictHorizon
-			 * on a standby server.
-			 */
-			XLogRegisterData(deletable,
-							 ndeletable * sizeof(OffsetNumber));
+	/*
+	 * The tableam may have reordered and shrunk the deltids array, so map
+	 * what it found back onto page offsets, which PageIndexMultiDelete wants
+	 * in ascending order.
+	 */
+	memset(isdeletable, 0, sizeof(isdeletable));
+	for (int i = 0; i < delstate.ndeltids; i++)
+	{
+		TM_IndexStatus *dstatus = &delstate.status[delstate.deltids[i].id];
 
-			XLogRegisterBuffer(1, metabuf, REGBUF_STANDARD);
+		if (dstatus->knowndeletable)
+			isdeletable[dstatus->idxoffnum] = true;
+	}
+	pfree(delstate.deltids);
+	pfree(delstate.status);
 
-			recptr = XLogInsert(RM_HASH_ID, XLOG_HASH_VACUUM_ONE_PAGE);
+	for (offnum = FirstOffsetNumber;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		if (isdeletable[offnum])
+			deletable[ndeletable++] = offnum;
+	}
 
-			PageSetLSN(BufferGetPage(buf), recptr);
-			PageSetLSN(BufferGetPage(metabuf), recptr);
-		}
+	if (ndeletable > 0)
+	{
+		_hash_delitems(rel, hrel, metabuf, buf, deletable, ndeletable,
+					   snapshotConflictHorizon);
+	}
+}
+
+/*
+ * _hash_delitems - physically delete the given items from one index page.
+ *
+ * Shared by simple and bottom-up deletion.  Both are WAL-logged the same way,
+ * so that standbys can resolve conflicts against snapshotConflictHorizon.
+ * Caller must hold a cleanup lock on buf.
+ */
+static void
+_hash_delitems(Relation rel, Relation hrel, Buffer metabuf, Buffer buf,
+			   OffsetNumber *deletable, int ndeletable,
+			   TransactionId snapshotConflictHorizon)
+{
+	Page		page = BufferGetPage(buf);
+	HashPageOpaque pageopaque;
+	HashMetaPage metap;
+
+	/*
+	 * Write-lock the meta page so that we can decrement tuple count.
+	 */
+	LockBuffer(metabuf, BUFFER_LOCK_EXCLUSIVE);
+
+	/* No ereport(ERROR) until changes are logged */
+	START_CRIT_SECTION();
+
+	PageIndexMultiDelete(page, deletable, ndeletable);
+
+	/*
+	 * Mark the page as not containing any LP_DEAD items. This is not
+	 * certainly true (there might be some that have recently been marked,
+	 * but weren't included in our target-item list), but it will almost
+	 * always be true and it doesn't seem worth an additional page scan to
+	 * check it. Remember that LH_PAGE_HAS_DEAD_TUPLES is only a hint
+	 * anyway.
+	 */
+	pageopaque = HashPageGetOpaque(page);
+	pageopaque->hasho_flag &= ~LH_PAGE_HAS_DEAD_TUPLES;
+
+	metap = HashPageGetMeta(BufferGetPage(metabuf));
+	metap->hashm_ntuples -= ndeletable;
 
-		END_CRIT_SECTION();
+	MarkBufferDirty(buf);
+	MarkBufferDirty(metabuf);
+
+	/* XLOG stuff */
+	if (RelationNeedsWAL(rel))
+	{
+		xl_hash_vacuum_one_page xlrec;
+		XLogRecPtr	recptr;
+
+		xlrec.isCatalogRel = RelationIsAccessibleInLogicalDecoding(hrel);
+		xlrec.snapshotConflictHorizon = snapshotConflictHorizon;
+		xlrec.ntuples = ndeletable;
+
+		XLogBeginInsert();
+		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
+		XLogRegisterData(&xlrec, SizeOfHashVacuumOnePage);
 
 		/*
-		 * Releasing write lock on meta page as we have updated the tuple
-		 * count.
+		 * We need the target-offsets array whether or not we store the whole
+		 * buffer, to allow us to find the snapshotConflictHorizon on a
+		 * standby server.
 		 */
-		LockBuffer(metabuf, BUFFER_LOCK_UNLOCK);
+		XLogRegisterData(deletable,
+						 ndeletable * sizeof(OffsetNumber));
+
+		XLogRegisterBuffer(1, metabuf, REGBUF_STANDARD);
+
+		recptr = XLogInsert(RM_HASH_ID, XLOG_HASH_VACUUM_ONE_PAGE);
+
+		PageSetLSN(BufferGetPage(buf), recptr);
+		PageSetLSN(BufferGetPage(metabuf), recptr);
 	}
+
+	END_CRIT_SECTION();
+
+	/*
+	 * Releasing write lock on meta page as we have updated the tuple count.
+	 */
+	LockBuffer(metabuf, BUFFER_LOCK_UNLOCK);
 }
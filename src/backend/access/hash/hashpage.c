@@ -47,6 +47,8 @@ static void _hash_splitbucket(Relation rel, Buffer metabuf,
 							  uint32 maxbucket,
 							  uint32 highmask, uint32 lowmask);
 static void log_split_page(Relation rel, Buffer buf);
+static int32 _hash_target_ffactor(Relation rel);
+static uint32 _hash_initial_num_buckets(double num_tuples, uint16 ffactor);
 
 
 /*
@@ -311,6 +313,65 @@ _hash_dropscanbuf(Relation rel, HashScanOpaque so)
 }
 
 
+/*
+ *	_hash_target_ffactor() -- Determine the target fill factor (in tuples per
+ *		bucket) for a hash index.
+ *
+ * The idea is to make the fill factor correspond to pages about as full as
+ * the user-settable fillfactor parameter says.  We can compute it exactly
+ * since the index datatype (i.e. uint32 hash key) is fixed-width.
+ */
+static int32
+_hash_target_ffactor(Relation rel)
+{
+	int32		data_width;
+	int32		item_width;
+	int32		ffactor;
+
+	data_width = sizeof(uint32);
+	item_width = MAXALIGN(sizeof(IndexTupleData)) + MAXALIGN(data_width) +
+		sizeof(ItemIdData);		/* include the line pointer */
+	ffactor = HashGetTargetPageUsage(rel) / item_width;
+	/* keep to a sane range */
+	if (ffactor < 10)
+		ffactor = 10;
+
+	return ffactor;
+}
+
+/*
+ *	_hash_initial_num_buckets() -- Choose the number of initial bucket pages.
+ *
+ * The number of buckets is chosen to match the fill factor given the
+ * estimated number of tuples.  We round up the result to the total number of
+ * buckets which has to be allocated before using its hashm_spares element.
+ * However always force at least 2 bucket pages.  The upper limit is
+ * determined by considerations explained in _hash_expandtable().
+ */
+static uint32
+_hash_initial_num_buckets(double num_tuples, uint16 ffactor)
+{
+	double		dnumbuckets;
+
+	dnumbuckets = num_tuples / ffactor;
+	if (dnumbuckets <= 2.0)
+		return 2;
+	else if (dnumbuckets >= (double) 0x40000000)
+		return 0x40000000;
+	else
+		return _hash_get_totalbuckets(_hash_spareindex(dnumbuckets));
+}
+
+/*
+ *	_hash_estimate_num_buckets() -- Number of buckets _hash_init() would
+ *		create for a new index on num_tuples tuples.
+ */
+uint32
+_hash_estimate_num_buckets(Relation rel, double num_tuples)
+{
+	return _hash_initial_num_buckets(num_tuples, _hash_target_ffactor(rel));
+}
+
 /*
  *	_hash_init() -- Initialize the metadata page of a hash index,
  *				the initial buckets, and the initial bitmap page.
@@ -332,8 +393,6 @@ _hash_init(Relation rel, double num_tuples, ForkNumber forkNum)
 	Page		pg;
 	HashMetaPage metap;
 	RegProcedure procid;
-	int32		data_width;
-	int32		item_width;
 	int32		ffactor;
 	uint32		num_buckets;
 	uint32		i;
@@ -351,19 +410,7 @@ _hash_init(Relation rel, double num_tuples, ForkNumber forkNum)
 	 */
 	use_wal = RelationNeedsWAL(rel) || forkNum == INIT_FORKNUM;
 
-	/*
-	 * Determine the target fill factor (in tuples per bucket) for this index.
-	 * The idea is to make the fill factor correspond to pages about as full
-	 * as the user-settable fillfactor parameter says.  We can compute it
-	 * exactly since the index datatype (i.e. uint32 hash key) is fixed-width.
-	 */
-	data_width = sizeof(uint32);
-	item_width = MAXALIGN(sizeof(IndexTupleData)) + MAXALIGN(data_width) +
-		sizeof(ItemIdData);		/* include the line pointer */
-	ffactor = HashGetTargetPageUsage(rel) / item_width;
-	/* keep to a sane range */
-	if (ffactor < 10)
-		ffactor = 10;
+	ffactor = _hash_target_ffactor(rel);
 
 	procid = index_getprocid(rel, 1, HASHSTANDARD_PROC);
 
@@ -501,26 +548,11 @@ _hash_init_metabuffer(Buffer buf, double num_tuples, RegProcedure procid,
 	HashMetaPage metap;
 	HashPageOpaque pageopaque;
 	Page		page;
-	double		dnumbuckets;
 	uint32		num_buckets;
 	uint32		spare_index;
 	uint32		lshift;
 
-	/*
-	 * Choose the number of initial bucket pages to match the fill factor
-	 * given the estimated number of tuples.  We round up the result to the
-	 * total number of buckets which has to be allocated before using its
-	 * hashm_spares element. However always force at least 2 bucket pages. The
-	 * upper limit is determined by considerations explained in
-	 * _hash_expandtable().
-	 */
-	dnumbuckets = num_tuples / ffactor;
-	if (dnumbuckets <= 2.0)
-		num_buckets = 2;
-	else if (dnumbuckets >= (double) 0x40000000)
-		num_buckets = 0x40000000;
-	else
-		num_buckets = _hash_get_totalbuckets(_hash_spareindex(dnumbuckets));
+	num_buckets = _hash_initial_num_buckets(num_tuples, ffactor);
 
 	spare_index = _hash_spareindex(num_buckets);
 	Assert(spare_index < HASH_MAX_SPLITPOINTS);
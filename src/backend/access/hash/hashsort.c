@@ -13,6 +13,11 @@
  * hash code value.  That's no big problem though, since we'll still have
  * plenty of locality of access.
  *
+ * The heap scan and sort can be performed by parallel workers.  Each
+ * participant sorts its share of the tuples into a "partial" tuplesort, and
+ * the leader merges them while inserting into the index.  The insertion
+ * phase itself is always performed by the leader alone.
+ *
  *
  * Portions Copyright (c) 1996-2025, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -26,12 +31,25 @@
 #include "postgres.h"
 
 #include "access/hash.h"
+#include "access/parallelbuild.h"
 #include "commands/progress.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/pg_bitutils.h"
 #include "utils/tuplesort.h"
 
+/*
+ * Hash-specific state shared with the workers of a parallel build (see
+ * ParallelBuildSharedGetAmShared()).
+ */
+typedef struct HashShared
+{
+	/*
+	 * Number of buckets in the index; workers need this to compute the masks
+	 * that their tuplesorts sort by.
+	 */
+	uint32		num_buckets;
+} HashShared;
 
 /*
  * Status record for spooling/sorting phase.
@@ -39,8 +57,15 @@
 struct HSpool
 {
 	Tuplesortstate *sortstate;	/* state data for tuplesort.c */
+	Relation	heap;
 	Relation	index;
 
+	/*
+	 * leader is only present when a parallel index build is performed, and
+	 * only in the leader process.
+	 */
+	ParallelBuildLeader *leader;
+
 	/*
 	 * We sort the hash keys based on the buckets they belong to, then by the
 	 * hash values themselves, to optimize insertions onto hash pages.  The
@@ -50,30 +75,63 @@ struct HSpool
 	uint32		high_mask;
 	uint32		low_mask;
 	uint32		max_buckets;
+
+	/* number of tuples spooled by a parallel participant */
+	double		indtuples;
 };
 
+static void _h_spoolinit_masks(HSpool *hspool, uint32 num_buckets);
+static void _h_leader_participate_as_worker(ParallelBuildLeader *leader,
+											void *arg);
+static void _h_parallel_scan_and_sort(HSpool *hspool,
+									  ParallelBuildShared *shared,
+									  Sharedsort *sharedsort, int sortmem,
+									  bool progress);
+static void _h_parallel_build_callback(Relation index, ItemPointer tid,
+									   Datum *values, bool *isnull,
+									   bool tupleIsAlive, void *state);
+
 
 /*
  * create and initialize a spool structure
+ *
+ * If nworkers is greater than zero, try to launch that many parallel workers
+ * to scan the heap and sort the tuples.  The caller must then collect the
+ * results of the scan with _h_parallel_heapscan() rather than scanning the
+ * heap itself; _h_spoolisparallel() tells which is the case.
  */
 HSpool *
-_h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
+_h_spoolinit(Relation heap, Relation index, uint32 num_buckets,
+			 bool isconcurrent, int nworkers)
 {
 	HSpool	   *hspool = (HSpool *) palloc0(sizeof(HSpool));
+	SortCoordinate coordinate = NULL;
 
+	hspool->heap = heap;
 	hspool->index = index;
+	_h_spoolinit_masks(hspool, num_buckets);
+
+	/* Attempt to launch parallel worker scan when required */
+	if (nworkers > 0)
+	{
+		HashShared	hashshared;
+
+		hashshared.num_buckets = num_buckets;
+		hspool->leader = parallel_build_begin("_hash_parallel_build_main",
+											  heap, index, isconcurrent,
+											  nworkers, 1,
+											  &hashshared, sizeof(HashShared),
+											  _h_leader_participate_as_worker,
+											  hspool);
+	}
 
 	/*
-	 * Determine the bitmask for hash code values.  Since there are currently
-	 * num_buckets buckets in the index, the appropriate mask can be computed
-	 * as follows.
-	 *
-	 * NOTE : This hash mask calculation should be in sync with similar
-	 * calculation in _hash_init_metabuffer.
+	 * If parallel build requested and at least one worker process was
+	 * successfully launched, set up coordination state for the leader's
+	 * final merge of the participants' sorted runs.
 	 */
-	hspool->high_mask = pg_nextpower2_32(num_buckets + 1) - 1;
-	hspool->low_mask = (hspool->high_mask >> 1);
-	hspool->max_buckets = num_buckets - 1;
+	if (hspool->leader)
+		coordinate = parallel_build_leader_coordinate(hspool->leader, 0);
 
 	/*
 	 * We size the sort area as maintenance_work_mem rather than work_mem to
@@ -86,12 +144,31 @@ _h_spoolinit(Relation heap, Relation index, uint32 num_buckets)
 												   hspool->low_mask,
 												   hspool->max_buckets,
 												   maintenance_work_mem,
-												   NULL,
+												   coordinate,
 												   TUPLESORT_NONE);
 
 	return hspool;
 }
 
+/*
+ * Compute the bucket masks used to sort the tuples of a spool.
+ */
+static void
+_h_spoolinit_masks(HSpool *hspool, uint32 num_buckets)
+{
+	/*
+	 * Determine the bitmask for hash code values.  Since there are currently
+	 * num_buckets buckets in the index, the appropriate mask can be computed
+	 * as follows.
+	 *
+	 * NOTE : This hash mask calculation should be in sync with similar
+	 * calculation in _hash_init_metabuffer.
+	 */
+	hspool->high_mask = pg_nextpower2_32(num_buckets + 1) - 1;
+	hspool->low_mask = (hspool->high_mask >> 1);
+	hspool->max_buckets = num_buckets - 1;
+}
+
 /*
  * clean up a spool structure and its substructures.
  */
@@ -99,6 +176,11 @@ void
 _h_spooldestroy(HSpool *hspool)
 {
 	tuplesort_end(hspool->sortstate);
+
+	/* Shut down leader (and its workers), if parallel */
+	if (hspool->leader)
+		parallel_build_end(hspool->leader);
+
 	pfree(hspool);
 }
 
@@ -146,7 +228,7 @@ _h_indexbuild(HSpool *hspool, Relation heapRel)
 #endif
 
 		/* the tuples are sorted by hashkey, so pass 'sorted' as true */
-		_hash_doinsert(hspool->index, itup, heapRel, true);
+		_hash_doinsert(hspool->index, itup, heapRel, true, false);
 
 		/* allow insertion phase to be interrupted, and track progress */
 		CHECK_FOR_INTERRUPTS();
@@ -155,3 +237,167 @@ _h_indexbuild(HSpool *hspool, Relation heapRel)
 									 ++tups_done);
 	}
 }
+
+/*
+ * Does this spool use parallel workers to scan the heap?
+ */
+bool
+_h_spoolisparallel(HSpool *hspool)
+{
+	return hspool->leader != NULL;
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by _h_spoolinit() will already be
+ * underway within worker processes (when leader participates as a worker, we
+ * should end up here just as workers are finishing).
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+double
+_h_parallel_heapscan(HSpool *hspool, bool *brokenhotchain, double *indtuples)
+{
+	return parallel_build_wait_scan(hspool->leader, indtuples, NULL,
+									brokenhotchain);
+}
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_h_leader_participate_as_worker(ParallelBuildLeader *leader, void *arg)
+{
+	HSpool	   *hspool = (HSpool *) arg;
+	HSpool	   *leaderworker;
+	int			sortmem;
+
+	/* Allocate memory and initialize private spool */
+	leaderworker = (HSpool *) palloc0(sizeof(HSpool));
+	leaderworker->heap = hspool->heap;
+	leaderworker->index = hspool->index;
+	leaderworker->high_mask = hspool->high_mask;
+	leaderworker->low_mask = hspool->low_mask;
+	leaderworker->max_buckets = hspool->max_buckets;
+
+	/*
+	 * Might as well use reliable figure when doling out maintenance_work_mem
+	 * (when requested number of workers were not launched, this will be
+	 * somewhat higher than it is for other workers).
+	 */
+	sortmem = maintenance_work_mem / leader->nparticipanttuplesorts;
+
+	/* Perform work common to all participants */
+	_h_parallel_scan_and_sort(leaderworker, leader->shared,
+							  leader->sharedsort[0], sortmem, true);
+
+	pfree(leaderworker);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_hash_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	HSpool	   *hspool;
+	ParallelBuildShared *shared;
+	HashShared *hashshared;
+	Sharedsort *sharedsort[PARALLEL_BUILD_MAX_SORTS];
+	Relation	heapRel;
+	Relation	indexRel;
+	int			sortmem;
+
+	shared = parallel_build_worker_begin(seg, toc, &heapRel, &indexRel,
+										 sharedsort);
+	hashshared = (HashShared *) ParallelBuildSharedGetAmShared(shared);
+
+	/* Initialize worker's own spool */
+	hspool = (HSpool *) palloc0(sizeof(HSpool));
+	hspool->heap = heapRel;
+	hspool->index = indexRel;
+	_h_spoolinit_masks(hspool, hashshared->num_buckets);
+
+	/* Perform sorting of spool */
+	sortmem = maintenance_work_mem / shared->scantuplesortstates;
+	_h_parallel_scan_and_sort(hspool, shared, sharedsort[0], sortmem, false);
+
+	parallel_build_worker_end(toc, shared, heapRel, indexRel);
+}
+
+/*
+ * Perform a worker's portion of a parallel sort.
+ *
+ * This generates a tuplesort for the passed hspool.  All other spool fields
+ * should already be set when this is called.
+ *
+ * sortmem is the amount of working memory to use within each worker,
+ * expressed in KBs.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_h_parallel_scan_and_sort(HSpool *hspool, ParallelBuildShared *shared,
+						  Sharedsort *sharedsort, int sortmem, bool progress)
+{
+	double		reltuples;
+	bool		brokenhotchain;
+
+	/* Begin "partial" tuplesort */
+	hspool->sortstate =
+		tuplesort_begin_index_hash(hspool->heap,
+								   hspool->index,
+								   hspool->high_mask,
+								   hspool->low_mask,
+								   hspool->max_buckets,
+								   sortmem,
+								   parallel_build_worker_coordinate(sharedsort),
+								   TUPLESORT_NONE);
+
+	/* Join parallel scan */
+	reltuples = parallel_build_scan(shared, hspool->heap, hspool->index,
+									progress, _h_parallel_build_callback,
+									hspool, &brokenhotchain);
+
+	/* Execute this worker's part of the sort */
+	tuplesort_performsort(hspool->sortstate);
+
+	/* Done.  Record ambuild statistics, and let the leader know. */
+	parallel_build_scan_done(shared, reltuples, hspool->indtuples, false,
+							 brokenhotchain);
+
+	/* We can end tuplesorts immediately */
+	tuplesort_end(hspool->sortstate);
+}
+
+/*
+ * Per-tuple callback for table_index_build_scan in parallel participants.
+ *
+ * This is the spooling half of hashbuildCallback().
+ */
+static void
+_h_parallel_build_callback(Relation index,
+						   ItemPointer tid,
+						   Datum *values,
+						   bool *isnull,
+						   bool tupleIsAlive,
+						   void *state)
+{
+	HSpool	   *hspool = (HSpool *) state;
+	Datum		index_values[1];
+	bool		index_isnull[1];
+
+	/* convert data to a hash key; on failure, do not insert anything */
+	if (!_hash_convert_tuple(index,
+							 values, isnull,
+							 index_values, index_isnull))
+		return;
+
+	_h_spool(hspool, tid, index_values, index_isnull);
+
+	hspool->indtuples += 1;
+}
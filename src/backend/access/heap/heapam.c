@@ -511,6 +511,11 @@ heap_setscanlimits(TableScanDesc sscan, BlockNumber startBlk, BlockNumber numBlk
  * Per-tuple loop for heap_prepare_pagescan(). Pulled out so it can be called
  * multiple times, with constant arguments for all_visible,
  * check_serializable.
+ *
+ * If the page isn't all-visible, the tuples are first collected and then
+ * checked together with HeapTupleSatisfiesMVCCBatch(), which resolves each
+ * distinct xmin/xmax on the page only once and dirties the buffer at most
+ * once for any hint bits it sets.
  */
 pg_attribute_always_inline
 static int
@@ -519,35 +524,63 @@ page_collect_tuples(HeapScanDesc scan, Snapshot snapshot,
 					BlockNumber block, int lines,
 					bool all_visible, bool check_serializable)
 {
+	HeapTupleData tuples[MaxHeapTuplesPerPage];
+	bool		visible[MaxHeapTuplesPerPage];
+	int			nitems = 0;
 	int			ntup = 0;
 	OffsetNumber lineoff;
 
 	for (lineoff = FirstOffsetNumber; lineoff <= lines; lineoff++)
 	{
 		ItemId		lpp = PageGetItemId(page, lineoff);
-		HeapTupleData loctup;
-		bool		valid;
+		HeapTuple	loctup;
 
 		if (!ItemIdIsNormal(lpp))
 			continue;
 
-		loctup.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
-		loctup.t_len = ItemIdGetLength(lpp);
-		loctup.t_tableOid = RelationGetRelid(scan->rs_base.rs_rd);
-		ItemPointerSet(&(loctup.t_self), block, lineoff);
+		/*
+		 * If all tuples are visible and there's nothing else to check, just
+		 * remember the offset.
+		 */
+		if (all_visible && !check_serializable)
+		{
+			scan->rs_vistuples[ntup] = lineoff;
+			ntup++;
+			continue;
+		}
 
-		if (all_visible)
-			valid = true;
-		else
-			valid = HeapTupleSatisfiesVisibility(&loctup, snapshot, buffer);
+		loctup = &tuples[nitems];
+		loctup->t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+		loctup->t_len = ItemIdGetLength(lpp);
+		loctup->t_tableOid = RelationGetRelid(scan->rs_base.rs_rd);
+		ItemPointerSet(&(loctup->t_self), block, lineoff);
+		nitems++;
+	}
+
+	if (all_visible)
+	{
+		for (int i = 0; i < nitems; i++)
+			visible[i] = true;
+	}
+	else if (snapshot->snapshot_type == SNAPSHOT_MVCC)
+		(void) HeapTupleSatisfiesMVCCBatch(snapshot, buffer, nitems,
+										   tuples, visible);
+	else
+	{
+		for (int i = 0; i < nitems; i++)
+			visible[i] = HeapTupleSatisfiesVisibility(&tuples[i], snapshot,
+													  buffer);
+	}
 
+	for (int i = 0; i < nitems; i++)
+	{
 		if (check_serializable)
-			HeapCheckForSerializableConflictOut(valid, scan->rs_base.rs_rd,
-												&loctup, buffer, snapshot);
+			HeapCheckForSerializableConflictOut(visible[i], scan->rs_base.rs_rd,
+												&tuples[i], buffer, snapshot);
 
-		if (valid)
+		if (visible[i])
 		{
-			scan->rs_vistuples[ntup] = lineoff;
+			scan->rs_vistuples[ntup] = ItemPointerGetOffsetNumber(&tuples[i].t_self);
 			ntup++;
 		}
 	}
@@ -2395,8 +2428,7 @@ heap_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
 	AssertHasSnapshotForToast(relation);
 
 	needwal = RelationNeedsWAL(relation);
-	saveFreeSpace = RelationGetTargetPageFreeSpace(relation,
-												   HEAP_DEFAULT_FILLFACTOR);
+	saveFreeSpace = RelationGetHeapTargetFreeSpace(relation);
 
 	/* Toast and set header data in all the slots */
 	heaptuples = palloc(ntuples * sizeof(HeapTuple));
@@ -7,7 +7,8 @@
  * "hint" status bits if we see that the inserting or deleting transaction
  * has now committed or aborted (and it is safe to set the hint bits).
  * If the hint bits are changed, MarkBufferDirtyHint is called on
- * the passed-in buffer.  The caller must hold not only a pin, but at least
+ * the passed-in buffer (once per page, in the case of
+ * HeapTupleSatisfiesMVCCBatch).  The caller must hold not only a pin, but at least
  * shared buffer content lock on the buffer containing the tuple.
  *
  * NOTE: When using a non-MVCC snapshot, we must check
@@ -39,6 +40,8 @@
  *
  *	 HeapTupleSatisfiesMVCC()
  *		  visible to supplied snapshot, excludes current command
+ *	 HeapTupleSatisfiesMVCCBatch()
+ *		  like HeapTupleSatisfiesMVCC(), for many tuples on one page
  *	 HeapTupleSatisfiesUpdate()
  *		  visible to instant snapshot, with user-supplied command
  *		  counter and more complex result
@@ -131,6 +134,120 @@ SetHintBits(HeapTupleHeader tuple, Buffer buffer,
 	MarkBufferDirtyHint(buffer, true);
 }
 
+/*
+ * State kept across the tuples of one page by HeapTupleSatisfiesMVCCBatch().
+ *
+ * Tuples on the same page frequently share their xmin and xmax, for example
+ * after a bulk load, so we remember how each distinct XID was resolved
+ * against the snapshot, and resolve it only once per page.  The XIDs are
+ * remembered in a small direct-mapped table; a collision merely costs a
+ * repeated lookup.
+ */
+#define MVCC_BATCH_XID_SLOTS	32
+
+typedef enum MVCCXidStatus
+{
+	MVCC_XID_UNKNOWN = 0,		/* slot not filled yet */
+	MVCC_XID_CURRENT,			/* one of our own (sub)transactions */
+	MVCC_XID_IN_PROGRESS,		/* in progress according to the snapshot */
+	MVCC_XID_COMMITTED,			/* committed before the snapshot */
+	MVCC_XID_ABORTED,			/* aborted or crashed */
+} MVCCXidStatus;
+
+typedef struct MVCCBatchState
+{
+	/* hint bits were set, but the buffer hasn't been marked dirty yet */
+	bool		dirty;
+
+	/* XID last found to be safe to set a commit hint bit for */
+	TransactionId hint_ok_xid;
+
+	TransactionId xids[MVCC_BATCH_XID_SLOTS];
+	MVCCXidStatus status[MVCC_BATCH_XID_SLOTS];
+} MVCCBatchState;
+
+/*
+ * SetHintBitsBatch()
+ *
+ * Like SetHintBits(), but for use by HeapTupleSatisfiesMVCCBatch().  Rather
+ * than marking the buffer dirty once per tuple, we remember that it needs to
+ * be done, and the caller does it once for the whole page.  We also remember
+ * the last XID that passed the commit LSN interlock check: the buffer's LSN
+ * and the flushed WAL position only ever advance, so the check can't fail
+ * for it later.
+ */
+static inline void
+SetHintBitsBatch(HeapTupleHeader tuple, Buffer buffer,
+				 uint16 infomask, TransactionId xid,
+				 MVCCBatchState *batch)
+{
+	if (batch == NULL)
+	{
+		SetHintBits(tuple, buffer, infomask, xid);
+		return;
+	}
+
+	if (TransactionIdIsValid(xid) &&
+		!TransactionIdEquals(xid, batch->hint_ok_xid))
+	{
+		/* NB: xid must be known committed here! */
+		XLogRecPtr	commitLSN = TransactionIdGetCommitLSN(xid);
+
+		if (BufferIsPermanent(buffer) && XLogNeedsFlush(commitLSN) &&
+			BufferGetLSNAtomic(buffer) < commitLSN)
+		{
+			/* not flushed and no LSN interlock, so don't set hint */
+			return;
+		}
+		batch->hint_ok_xid = xid;
+	}
+
+	tuple->t_infomask |= infomask;
+	batch->dirty = true;
+}
+
+/*
+ * MVCCResolveXid()
+ *
+ * Determine the status of a not-hinted xmin or xmax according to an MVCC
+ * snapshot, in the order HeapTupleSatisfiesMVCC() needs it checked:  first
+ * whether it's one of our own transactions, then whether it's still running
+ * according to the snapshot, and finally whether it committed.  If 'batch'
+ * is given, the result is remembered and reused for later tuples on the same
+ * page.
+ */
+static inline MVCCXidStatus
+MVCCResolveXid(TransactionId xid, Snapshot snapshot, MVCCBatchState *batch)
+{
+	MVCCXidStatus status;
+	int			slot = 0;
+
+	if (batch != NULL)
+	{
+		slot = xid % MVCC_BATCH_XID_SLOTS;
+		if (batch->status[slot] != MVCC_XID_UNKNOWN &&
+			TransactionIdEquals(batch->xids[slot], xid))
+			return batch->status[slot];
+	}
+
+	if (TransactionIdIsCurrentTransactionId(xid))
+		status = MVCC_XID_CURRENT;
+	else if (XidInMVCCSnapshot(xid, snapshot))
+		status = MVCC_XID_IN_PROGRESS;
+	else if (TransactionIdDidCommit(xid))
+		status = MVCC_XID_COMMITTED;
+	else
+		status = MVCC_XID_ABORTED;
+
+	if (batch != NULL)
+	{
+		batch->xids[slot] = xid;
+		batch->status[slot] = status;
+	}
+
+	return status;
+}
+
 /*
  * HeapTupleSetHintBits --- exported version of SetHintBits()
  *
@@ -956,11 +1073,12 @@ HeapTupleSatisfiesDirty(HeapTuple htup, Snapshot snapshot,
  * inserting/deleting transaction was still running --- which was more cycles
  * and more contention on ProcArrayLock.
  */
-static bool
+static pg_attribute_always_inline bool
 HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
-					   Buffer buffer)
+					   Buffer buffer, MVCCBatchState *batch)
 {
 	HeapTupleHeader tuple = htup->t_data;
+	MVCCXidStatus xidstatus;
 
 	/*
 	 * Assert that the caller has registered the snapshot.  This function
@@ -990,12 +1108,12 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 			{
 				if (TransactionIdDidCommit(xvac))
 				{
-					SetHintBits(tuple, buffer, HEAP_XMIN_INVALID,
-								InvalidTransactionId);
+					SetHintBitsBatch(tuple, buffer, HEAP_XMIN_INVALID,
+									 InvalidTransactionId, batch);
 					return false;
 				}
-				SetHintBits(tuple, buffer, HEAP_XMIN_COMMITTED,
-							InvalidTransactionId);
+				SetHintBitsBatch(tuple, buffer, HEAP_XMIN_COMMITTED,
+								 InvalidTransactionId, batch);
 			}
 		}
 		/* Used by pre-9.0 binary upgrades */
@@ -1008,17 +1126,18 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 				if (XidInMVCCSnapshot(xvac, snapshot))
 					return false;
 				if (TransactionIdDidCommit(xvac))
-					SetHintBits(tuple, buffer, HEAP_XMIN_COMMITTED,
-								InvalidTransactionId);
+					SetHintBitsBatch(tuple, buffer, HEAP_XMIN_COMMITTED,
+									 InvalidTransactionId, batch);
 				else
 				{
-					SetHintBits(tuple, buffer, HEAP_XMIN_INVALID,
-								InvalidTransactionId);
+					SetHintBitsBatch(tuple, buffer, HEAP_XMIN_INVALID,
+									 InvalidTransactionId, batch);
 					return false;
 				}
 			}
 		}
-		else if (TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetRawXmin(tuple)))
+		else if ((xidstatus = MVCCResolveXid(HeapTupleHeaderGetRawXmin(tuple),
+											 snapshot, batch)) == MVCC_XID_CURRENT)
 		{
 			if (HeapTupleHeaderGetCmin(tuple) >= snapshot->curcid)
 				return false;	/* inserted after scan started */
@@ -1050,8 +1169,8 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 			if (!TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetRawXmax(tuple)))
 			{
 				/* deleting subtransaction must have aborted */
-				SetHintBits(tuple, buffer, HEAP_XMAX_INVALID,
-							InvalidTransactionId);
+				SetHintBitsBatch(tuple, buffer, HEAP_XMAX_INVALID,
+								 InvalidTransactionId, batch);
 				return true;
 			}
 
@@ -1060,16 +1179,16 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 			else
 				return false;	/* deleted before scan started */
 		}
-		else if (XidInMVCCSnapshot(HeapTupleHeaderGetRawXmin(tuple), snapshot))
+		else if (xidstatus == MVCC_XID_IN_PROGRESS)
 			return false;
-		else if (TransactionIdDidCommit(HeapTupleHeaderGetRawXmin(tuple)))
-			SetHintBits(tuple, buffer, HEAP_XMIN_COMMITTED,
-						HeapTupleHeaderGetRawXmin(tuple));
+		else if (xidstatus == MVCC_XID_COMMITTED)
+			SetHintBitsBatch(tuple, buffer, HEAP_XMIN_COMMITTED,
+							 HeapTupleHeaderGetRawXmin(tuple), batch);
 		else
 		{
 			/* it must have aborted or crashed */
-			SetHintBits(tuple, buffer, HEAP_XMIN_INVALID,
-						InvalidTransactionId);
+			SetHintBitsBatch(tuple, buffer, HEAP_XMIN_INVALID,
+							 InvalidTransactionId, batch);
 			return false;
 		}
 	}
@@ -1118,7 +1237,10 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 
 	if (!(tuple->t_infomask & HEAP_XMAX_COMMITTED))
 	{
-		if (TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetRawXmax(tuple)))
+		xidstatus = MVCCResolveXid(HeapTupleHeaderGetRawXmax(tuple),
+								   snapshot, batch);
+
+		if (xidstatus == MVCC_XID_CURRENT)
 		{
 			if (HeapTupleHeaderGetCmax(tuple) >= snapshot->curcid)
 				return true;	/* deleted after scan started */
@@ -1126,20 +1248,20 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 				return false;	/* deleted before scan started */
 		}
 
-		if (XidInMVCCSnapshot(HeapTupleHeaderGetRawXmax(tuple), snapshot))
+		if (xidstatus == MVCC_XID_IN_PROGRESS)
 			return true;
 
-		if (!TransactionIdDidCommit(HeapTupleHeaderGetRawXmax(tuple)))
+		if (xidstatus == MVCC_XID_ABORTED)
 		{
 			/* it must have aborted or crashed */
-			SetHintBits(tuple, buffer, HEAP_XMAX_INVALID,
-						InvalidTransactionId);
+			SetHintBitsBatch(tuple, buffer, HEAP_XMAX_INVALID,
+							 InvalidTransactionId, batch);
 			return true;
 		}
 
 		/* xmax transaction committed */
-		SetHintBits(tuple, buffer, HEAP_XMAX_COMMITTED,
-					HeapTupleHeaderGetRawXmax(tuple));
+		SetHintBitsBatch(tuple, buffer, HEAP_XMAX_COMMITTED,
+						 HeapTupleHeaderGetRawXmax(tuple), batch);
 	}
 	else
 	{
@@ -1153,6 +1275,46 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 	return false;
 }
 
+/*
+ * HeapTupleSatisfiesMVCCBatch
+ *		Check the visibility of all the given tuples, which must all be on
+ *		the page in 'buffer', against an MVCC snapshot.
+ *
+ * This is equivalent to calling HeapTupleSatisfiesVisibility() on each tuple
+ * in turn, but each distinct xmin and xmax value on the page is resolved only
+ * once, and if any hint bits are set, the buffer is marked dirty only once at
+ * the end.  visible[i] is set to the result for tuples[i].  Returns the
+ * number of visible tuples.
+ *
+ * The buffer must be at least share locked.
+ */
+int
+HeapTupleSatisfiesMVCCBatch(Snapshot snapshot, Buffer buffer,
+							int ntups, HeapTupleData *tuples, bool *visible)
+{
+	MVCCBatchState batch;
+	int			nvisible = 0;
+
+	Assert(snapshot->snapshot_type == SNAPSHOT_MVCC);
+
+	batch.dirty = false;
+	batch.hint_ok_xid = InvalidTransactionId;
+	memset(batch.status, 0, sizeof(batch.status));
+
+	for (int i = 0; i < ntups; i++)
+	{
+		visible[i] = HeapTupleSatisfiesMVCC(&tuples[i], snapshot, buffer,
+											&batch);
+		if (visible[i])
+			nvisible++;
+	}
+
+	if (batch.dirty)
+		MarkBufferDirtyHint(buffer, true);
+
+	return nvisible;
+}
+
 
 /*
  * HeapTupleSatisfiesVacuum
@@ -1778,7 +1940,7 @@ HeapTupleSatisfiesVisibility(HeapTuple htup, Snapshot snapshot, Buffer buffer)
 	switch (snapshot->snapshot_type)
 	{
 		case SNAPSHOT_MVCC:
-			return HeapTupleSatisfiesMVCC(htup, snapshot, buffer);
+			return HeapTupleSatisfiesMVCC(htup, snapshot, buffer, NULL);
 		case SNAPSHOT_SELF:
 			return HeapTupleSatisfiesSelf(htup, snapshot, buffer);
 		case SNAPSHOT_ANY:
@@ -620,7 +620,8 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
  * attrsize is the total size of the TOAST value.
  * sliceoffset is the byte offset within the TOAST value from which to fetch.
  * slicelength is the number of bytes to be fetched from the TOAST value.
- * result is the varlena into which the results should be written.
+ * result is the varlena into which the results should be written; only its
+ * data area is written, never its header.
  */
 void
 heap_fetch_toast_slice(Relation toastrel, Oid valueid, int32 attrsize,
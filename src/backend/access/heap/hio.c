@@ -19,9 +19,39 @@
 #include "access/hio.h"
 #include "access/htup_details.h"
 #include "access/visibilitymap.h"
+#include "catalog/catalog.h"
+#include "miscadmin.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+/*
+ * Number of times RelationGetBufferForTuple() will move on to another page
+ * suggested by the FSM, instead of waiting for the lock on a busy one.
+ */
+#define MAX_BUSY_PAGE_SKIPS 3
+
+/*
+ * Parameters of the adaptive free space reserve, see
+ * RelationGetHeapTargetFreeSpace().
+ */
+#define HEAP_RESERVE_RECHECK_INTERVAL	1024	/* calls between recomputes */
+#define HEAP_RESERVE_MIN_UPDATES		1000	/* updates needed to adapt */
+#define HEAP_RESERVE_MAX_PERCENT		20	/* most space ever reserved */
+
+/* State of the adaptive free space reserve, kept in rd_amcache */
+typedef struct HeapReserveCache
+{
+	uint32		ncalls;			/* calls since reserve was computed */
+	Size		reserve;		/* bytes to keep free on each page */
+	/* the table's counters when the reserve was last decided */
+	PgStat_Counter tuples_inserted;
+	PgStat_Counter tuples_updated;
+	PgStat_Counter tuples_newpage_updated;
+} HeapReserveCache;
 
 
 /*
@@ -431,6 +461,109 @@ RelationAddBlocks(Relation relation, BulkInsertState bistate,
 #undef MAX_BUFFERS_TO_EXTEND_BY
 }
 
+/*
+ * Update the adaptive free space reserve of a table from its cumulative
+ * statistics.
+ *
+ * An UPDATE whose new version goes to a different page is one that could
+ * have been a HOT update (or at least stayed on the same page) if there had
+ * been room.  If that happens to a noticeable fraction of a table's updates,
+ * we reserve up to HEAP_RESERVE_MAX_PERCENT of each page, scaled by how
+ * update-heavy the table is relative to inserts.
+ *
+ * The decision is made on the change in the counters since the last one, so
+ * that it reflects recent activity rather than the whole history of the
+ * table.  Once a reserve is in place, it is only ever raised: when it works,
+ * updates stop moving to other pages, and taking that as a reason to drop
+ * the reserve would just let pages fill up and bring the moves back.  A
+ * relcache rebuild starts over from the cumulative counters.
+ */
+static void
+heap_update_reserve(Relation relation, HeapReserveCache *cache)
+{
+	PgStat_Counter tuples_inserted;
+	PgStat_Counter tuples_updated;
+	PgStat_Counter tuples_newpage_updated;
+	PgStat_Counter inserted;
+	PgStat_Counter updated;
+	PgStat_Counter newpage_updated;
+	double		intensity;
+	Size		reserve;
+
+	if (!pgstat_fetch_tab_update_counts(relation, &tuples_inserted,
+										&tuples_updated,
+										&tuples_newpage_updated))
+		return;
+
+	inserted = tuples_inserted - cache->tuples_inserted;
+	updated = tuples_updated - cache->tuples_updated;
+	newpage_updated = tuples_newpage_updated - cache->tuples_newpage_updated;
+
+	/* Too few updates to go by; keep accumulating */
+	if (updated < HEAP_RESERVE_MIN_UPDATES)
+		return;
+
+	cache->tuples_inserted = tuples_inserted;
+	cache->tuples_updated = tuples_updated;
+	cache->tuples_newpage_updated = tuples_newpage_updated;
+
+	/* Updates mostly stay on their page, possibly thanks to the reserve */
+	if (newpage_updated < updated / 10)
+		return;
+
+	intensity = Min(1.0, (double) updated / Max(inserted, 1));
+	reserve = BLCKSZ * (int) (HEAP_RESERVE_MAX_PERCENT * intensity) / 100;
+	cache->reserve = Max(cache->reserve, reserve);
+}
+
+/*
+ * RelationGetHeapTargetFreeSpace
+ *		Returns the free space to leave on each page of a heap, in bytes.
+ *
+ * If the fillfactor storage parameter is set, this is the space it reserves;
+ * an explicit fillfactor of 100 turns the reserve off.  Otherwise, for user
+ * tables, it's an adaptive reserve derived from the table's update
+ * statistics, which lets UPDATEs on update-heavy tables find room for HOT
+ * updates without fillfactor tuning.  Inserts (RelationGetBufferForTuple,
+ * heap_multi_insert) leave that much space free, and opportunistic pruning
+ * tries to restore it.
+ *
+ * The reserve is cached in rd_amcache and revisited every
+ * HEAP_RESERVE_RECHECK_INTERVAL calls, since this is called for every
+ * insert and every page that heap_page_prune_opt() looks at.
+ */
+Size
+RelationGetHeapTargetFreeSpace(Relation relation)
+{
+	HeapReserveCache *cache;
+
+	if (RelationFillFactorIsSet(relation))
+		return RelationGetTargetPageFreeSpace(relation,
+											  HEAP_DEFAULT_FILLFACTOR);
+
+	/* Only adapt for user tables */
+	if (IsBootstrapProcessingMode() ||
+		relation->rd_rel->relkind != RELKIND_RELATION ||
+		IsCatalogRelation(relation))
+		return 0;
+
+	cache = (HeapReserveCache *) relation->rd_amcache;
+	if (cache == NULL)
+	{
+		cache = MemoryContextAllocZero(CacheMemoryContext,
+									   sizeof(HeapReserveCache));
+		heap_update_reserve(relation, cache);
+		relation->rd_amcache = cache;
+	}
+	else if (++cache->ncalls >= HEAP_RESERVE_RECHECK_INTERVAL)
+	{
+		cache->ncalls = 0;
+		heap_update_reserve(relation, cache);
+	}
+
+	return cache->reserve;
+}
+
 /*
  * RelationGetBufferForTuple
  *
@@ -488,8 +621,9 @@ RelationAddBlocks(Relation relation, BulkInsertState bistate,
  *	BULKWRITE buffer selection strategy object to the buffer manager.
  *	Passing NULL for bistate selects the default behavior.
  *
- *	We don't fill existing pages further than the fillfactor, except for large
- *	tuples in nearly-empty pages.  This is OK since this routine is not
+ *	We don't fill existing pages further than the fillfactor (or the adaptive
+ *	reserve, see RelationGetHeapTargetFreeSpace), except for large tuples in
+ *	nearly-empty pages.  This is OK since this routine is not
  *	consulted when updating a tuple and keeping it on the same page, which is
  *	the scenario fillfactor is meant to reserve space for.
  *
@@ -514,6 +648,7 @@ RelationGetBufferForTuple(Relation relation, Size len,
 				otherBlock;
 	bool		unlockedTargetBuffer;
 	bool		recheckVmPins;
+	int			nbusyskips = 0;
 
 	len = MAXALIGN(len);		/* be conservative */
 
@@ -534,8 +669,7 @@ RelationGetBufferForTuple(Relation relation, Size len,
 						len, MaxHeapTupleSize)));
 
 	/* Compute desired extra freespace due to fillfactor option */
-	saveFreeSpace = RelationGetTargetPageFreeSpace(relation,
-												   HEAP_DEFAULT_FILLFACTOR);
+	saveFreeSpace = RelationGetHeapTargetFreeSpace(relation);
 
 	/*
 	 * Since pages without tuples can still have line pointers, we consider
@@ -625,7 +759,37 @@ loop:
 				(PageGetMaxOffsetNumber(BufferGetPage(buffer)) == 0))
 				visibilitymap_pin(relation, targetBlock, vmbuffer);
 
-			LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+			/*
+			 * If somebody else holds the lock, it's most likely another
+			 * inserter that picked the same page.  Rather than queuing up
+			 * behind it, ask the FSM for a different page; successive FSM
+			 * searches start at different slots, which spreads concurrent
+			 * inserters over the pages with free space.  Only do this a few
+			 * times, and only if the FSM offers another page: a busy page is
+			 * no reason to extend the relation.
+			 */
+			if (use_fsm && bistate == NULL &&
+				nbusyskips < MAX_BUSY_PAGE_SKIPS)
+			{
+				if (!ConditionalLockBuffer(buffer))
+				{
+					BlockNumber altBlock;
+
+					nbusyskips++;
+					altBlock = GetPageWithFreeSpace(relation, targetFreeSpace);
+					if (altBlock != InvalidBlockNumber &&
+						altBlock != targetBlock)
+					{
+						ReleaseBuffer(buffer);
+						targetBlock = altBlock;
+						continue;
+					}
+
+					LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+				}
+			}
+			else
+				LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
 		}
 		else if (otherBlock == targetBlock)
 		{
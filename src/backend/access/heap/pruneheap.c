@@ -16,10 +16,11 @@
 
 #include "access/heapam.h"
 #include "access/heapam_xlog.h"
+#include "access/hio.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
 #include "access/transam.h"
-#include "access/visibilitymapdefs.h"
+#include "access/visibilitymap.h"
 #include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "commands/vacuum.h"
@@ -44,6 +45,8 @@ typedef struct
 	bool		mark_unused_now;
 	/* whether to attempt freezing tuples */
 	bool		attempt_freeze;
+	/* whether to work out all_visible without freezing */
+	bool		check_visible;
 	struct VacuumCutoffs *cutoffs;
 
 	/*-------------------------------------------------------
@@ -212,6 +215,7 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 	TransactionId prune_xid;
 	GlobalVisState *vistest;
 	Size		minfree;
+	Buffer		vmbuffer = InvalidBuffer;
 
 	/*
 	 * We can't write WAL in recovery mode, so there's no point trying to
@@ -242,7 +246,7 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 	/*
 	 * We prune when a previous UPDATE failed to find enough space on the page
 	 * for a new tuple version, or when free space falls below the relation's
-	 * fill-factor target (but not less than 10%).
+	 * fill-factor target or adaptive reserve (but not less than 10%).
 	 *
 	 * Checking free space here is questionable since we aren't holding any
 	 * lock on the buffer; in the worst case we could get a bogus answer. It's
@@ -251,15 +255,27 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 	 * important than sometimes getting a wrong answer in what is after all
 	 * just a heuristic estimate.
 	 */
-	minfree = RelationGetTargetPageFreeSpace(relation,
-											 HEAP_DEFAULT_FILLFACTOR);
+	minfree = RelationGetHeapTargetFreeSpace(relation);
 	minfree = Max(minfree, BLCKSZ / 10);
 
 	if (PageIsFull(page) || PageGetHeapFreeSpace(page) < minfree)
 	{
+		/*
+		 * If the page isn't all-visible yet, pruning might leave it so.  Pin
+		 * the visibility map page now, so that we can set the bit without
+		 * doing I/O while holding the buffer lock.
+		 */
+		if (!PageIsAllVisible(page))
+			visibilitymap_pin(relation, BufferGetBlockNumber(buffer),
+							  &vmbuffer);
+
 		/* OK, try to get exclusive buffer lock */
 		if (!ConditionalLockBufferForCleanup(buffer))
+		{
+			if (BufferIsValid(vmbuffer))
+				ReleaseBuffer(vmbuffer);
 			return;
+		}
 
 		/*
 		 * Now that we have buffer lock, get accurate information about the
@@ -286,9 +302,32 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 				.cutoffs = NULL,
 			};
 
+			if (BufferIsValid(vmbuffer))
+				params.options |= HEAP_PAGE_PRUNE_CHECK_VISIBLE;
+
 			heap_page_prune_and_freeze(&params, &presult, &dummy_off_loc,
 									   NULL, NULL);
 
+			/*
+			 * If every remaining tuple is visible to everyone, set the page
+			 * all-visible now, rather than waiting for VACUUM to come along.
+			 * This makes index-only scans cheaper sooner, and lets the next
+			 * VACUUM skip the page.  We don't freeze here, so we never set
+			 * the all-frozen bit.
+			 */
+			if (presult.all_visible && !PageIsAllVisible(page))
+			{
+				Assert(presult.lpdead_items == 0);
+				Assert(!presult.all_frozen);
+
+				PageSetAllVisible(page);
+				MarkBufferDirty(buffer);
+				visibilitymap_set(relation, BufferGetBlockNumber(buffer),
+								  buffer, InvalidXLogRecPtr, vmbuffer,
+								  presult.vm_conflict_horizon,
+								  VISIBILITYMAP_ALL_VISIBLE);
+			}
+
 			/*
 			 * Report the number of tuples reclaimed to pgstats.  This is
 			 * presult.ndeleted minus the number of newly-LP_DEAD-set items.
@@ -311,6 +350,9 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
 		/* And release buffer lock */
 		LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
 
+		if (BufferIsValid(vmbuffer))
+			ReleaseBuffer(vmbuffer);
+
 		/*
 		 * We avoid reuse of any free space created on the page by unrelated
 		 * UPDATEs/INSERTs by opting to not update the FSM at this point.  The
@@ -338,6 +380,8 @@ prune_freeze_setup(PruneFreezeParams *params,
 	/* cutoffs must be provided if we will attempt freezing */
 	Assert(!(params->options & HEAP_PAGE_PRUNE_FREEZE) || params->cutoffs);
 	prstate->attempt_freeze = (params->options & HEAP_PAGE_PRUNE_FREEZE) != 0;
+	prstate->check_visible =
+		(params->options & HEAP_PAGE_PRUNE_CHECK_VISIBLE) != 0;
 	prstate->cutoffs = params->cutoffs;
 
 	/*
@@ -390,11 +434,10 @@ prune_freeze_setup(PruneFreezeParams *params,
 	 * whether the page will be all-visible and all-frozen after pruning and
 	 * freezing to help the caller to do that.
 	 *
-	 * Currently, only VACUUM sets the VM bits.  To save the effort, only do
-	 * the bookkeeping if the caller needs it.  Currently, that's tied to
-	 * HEAP_PAGE_PRUNE_FREEZE, but it could be a separate flag if you wanted
-	 * to update the VM bits without also freezing or freeze without also
-	 * setting the VM bits.
+	 * VACUUM sets the VM bits, and on-access pruning may set the all-visible
+	 * bit.  To save the effort, only do the bookkeeping if the caller needs
+	 * it, as indicated by HEAP_PAGE_PRUNE_FREEZE or, for all_visible alone,
+	 * HEAP_PAGE_PRUNE_CHECK_VISIBLE.
 	 *
 	 * In addition to telling the caller whether it can set the VM bit, we
 	 * also use 'all_visible' and 'all_frozen' for our own decision-making. If
@@ -414,6 +457,12 @@ prune_freeze_setup(PruneFreezeParams *params,
 		prstate->all_visible = true;
 		prstate->all_frozen = true;
 	}
+	else if (prstate->check_visible)
+	{
+		/* Without freezing, only all_visible can be worked out */
+		prstate->all_visible = true;
+		prstate->all_frozen = false;
+	}
 	else
 	{
 		/*
@@ -665,7 +714,15 @@ heap_page_will_freeze(Relation relation, Buffer buffer,
 	if (!prstate->attempt_freeze)
 	{
 		Assert(!prstate->all_frozen && prstate->nfrozen == 0);
-		Assert(prstate->lpdead_items == 0 || !prstate->all_visible);
+
+		/*
+		 * Without freezing, all_visible is only tracked for
+		 * HEAP_PAGE_PRUNE_CHECK_VISIBLE.  As when freezing, it doesn't
+		 * account for LP_DEAD items yet; our caller clears it if there are
+		 * any.
+		 */
+		Assert(prstate->lpdead_items == 0 || !prstate->all_visible ||
+			   prstate->check_visible);
 		return false;
 	}
 
@@ -786,9 +843,10 @@ heap_page_will_freeze(Relation relation, Buffer buffer,
  * 'new_relmin_mxid' arguments are required when freezing.  When
  * HEAP_PAGE_PRUNE_FREEZE option is passed, we also set presult->all_visible
  * and presult->all_frozen after determining whether or not to
- * opportunistically freeze, to indicate if the VM bits can be set.  They are
- * always set to false when the HEAP_PAGE_PRUNE_FREEZE option is not passed,
- * because at the moment only callers that also freeze need that information.
+ * opportunistically freeze, to indicate if the VM bits can be set.  Without
+ * it, the HEAP_PAGE_PRUNE_CHECK_VISIBLE option asks for just
+ * presult->all_visible, which on-access pruning uses to set the all-visible
+ * bit.  Otherwise both are always set to false.
  *
  * presult contains output parameters needed by callers, such as the number of
  * tuples removed and the offsets of dead items on the page after pruning.
@@ -1496,13 +1554,14 @@ heap_prune_record_unchanged_lp_normal(Page page, PruneState *prstate, OffsetNumb
 				xmin = HeapTupleHeaderGetXmin(htup);
 
 				/*
-				 * For now always use prstate->cutoffs for this test, because
-				 * we only update 'all_visible' and 'all_frozen' when freezing
-				 * is requested. We could use GlobalVisTestIsRemovableXid
-				 * instead, if a non-freezing caller wanted to set the VM bit.
+				 * Use prstate->cutoffs for this test when freezing, so that
+				 * our answer agrees with the freeze decisions.  Otherwise
+				 * (on-access pruning that wants to set the VM bit) use
+				 * vistest.
 				 */
-				Assert(prstate->cutoffs);
-				if (!TransactionIdPrecedes(xmin, prstate->cutoffs->OldestXmin))
+				if (prstate->cutoffs ?
+					!TransactionIdPrecedes(xmin, prstate->cutoffs->OldestXmin) :
+					!GlobalVisTestIsRemovableXid(prstate->vistest, xmin))
 				{
 					prstate->all_visible = false;
 					prstate->all_frozen = false;
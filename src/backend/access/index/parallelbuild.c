@@ -0,0 +1,541 @@
+/*-------------------------------------------------------------------------
+ *
+ * parallelbuild.c
+ *	  Infrastructure shared by parallel sort-based index builds.
+ *
+ * Several index AMs build their indexes by scanning the heap into a
+ * tuplesort and then loading the sorted tuples.  Such a build can be
+ * parallelized in the same way regardless of the AM: each worker, and the
+ * leader acting as a worker, scans part of the table and sorts its tuples
+ * into "partial" tuplesorts, and the leader then merges the sorted runs.
+ * This module sets up the parallel context, shared state and shared
+ * tuplesorts for that, and takes care of the bookkeeping common to all
+ * participants.  The AM supplies the worker entry point, the per-tuple
+ * callback, and whatever AM-specific state the workers need.
+ *
+ * Portions Copyright (c) 1996-2025, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/index/parallelbuild.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/parallelbuild.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "catalog/index.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/proc.h"
+#include "tcop/tcopprot.h"
+#include "utils/snapmgr.h"
+
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_BUILD_SHARED		UINT64CONST(0xA000000000000001)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xA000000000000002)
+#define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xA000000000000003)
+#define PARALLEL_KEY_BUFFER_USAGE		UINT64CONST(0xA000000000000004)
+/* PARALLEL_KEY_TUPLESORT + n is the key of the n'th shared tuplesort */
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xA000000000000010)
+
+/*
+ * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
+ * parallel index builds.  This may be useful as a debugging aid.
+#undef DISABLE_LEADER_PARTICIPATION
+ */
+
+static Size parallel_build_estimate_shared(Relation heap, Snapshot snapshot,
+										   Size amsharedsize);
+
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * function_name is the worker entry point, which must be listed in
+ * parallel.c's InternalParallelWorkers[].  It is expected to call
+ * parallel_build_worker_begin() and parallel_build_worker_end().
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * nsorts is the number of tuplesorts each participant fills, at most
+ * PARALLEL_BUILD_MAX_SORTS.
+ *
+ * amshared points to amsharedsize bytes of AM-specific state, which is
+ * copied into shared memory for the benefit of the workers (see
+ * ParallelBuildSharedGetAmShared()).
+ *
+ * Once the workers are launched, participate is called (unless this is a
+ * DISABLE_LEADER_PARTICIPATION build) to have the leader scan and sort its
+ * own share of the table.
+ *
+ * Returns the ParallelBuildLeader, which caller must use to shut down
+ * parallel mode by passing it to parallel_build_end() at the very end of
+ * its index build.  If not even a single worker process can be launched,
+ * returns NULL, and caller should proceed with a serial index build.
+ */
+ParallelBuildLeader *
+parallel_build_begin(const char *function_name, Relation heap, Relation index,
+					 bool isconcurrent, int request, int nsorts,
+					 const void *amshared, Size amsharedsize,
+					 ParallelBuildParticipateCB participate, void *arg)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estshared;
+	Size		estsort;
+	ParallelBuildShared *shared;
+	ParallelBuildLeader *leader;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+	bool		leaderparticipates = true;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	Assert(nsorts > 0 && nsorts <= PARALLEL_BUILD_MAX_SORTS);
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", function_name, request);
+
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Estimate size for our own PARALLEL_KEY_BUILD_SHARED workspace, and
+	 * PARALLEL_KEY_TUPLESORT tuplesort workspaces
+	 */
+	estshared = parallel_build_estimate_shared(heap, snapshot, amsharedsize);
+	shm_toc_estimate_chunk(&pcxt->estimator, estshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	for (int i = 0; i < nsorts; i++)
+		shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 1 + nsorts);
+
+	/*
+	 * Estimate space for WalUsage and BufferUsage -- PARALLEL_KEY_WAL_USAGE
+	 * and PARALLEL_KEY_BUFFER_USAGE.
+	 *
+	 * If there are no extensions loaded that care, we could skip this.  We
+	 * have no way of knowing whether anyone's looking at pgWalUsage or
+	 * pgBufferUsage, so do it unconditionally.
+	 */
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, back out (do serial build) */
+	if (pcxt->seg == NULL)
+	{
+		if (IsMVCCSnapshot(snapshot))
+			UnregisterSnapshot(snapshot);
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return NULL;
+	}
+
+	/* Store shared build state, for which we reserved space */
+	shared = (ParallelBuildShared *) shm_toc_allocate(pcxt->toc, estshared);
+	/* Initialize immutable state */
+	shared->heaprelid = RelationGetRelid(heap);
+	shared->indexrelid = RelationGetRelid(index);
+	shared->isconcurrent = isconcurrent;
+	shared->nsorts = nsorts;
+	shared->scantuplesortstates = scantuplesortstates;
+	shared->amsharedsize = amsharedsize;
+	shared->queryid = pgstat_get_my_query_id();
+	ConditionVariableInit(&shared->workersdonecv);
+	SpinLockInit(&shared->mutex);
+	/* Initialize mutable state */
+	shared->nparticipantsdone = 0;
+	shared->reltuples = 0.0;
+	shared->havedead = false;
+	shared->indtuples = 0.0;
+	shared->brokenhotchain = false;
+	if (amsharedsize > 0)
+		memcpy(ParallelBuildSharedGetAmShared(shared), amshared, amsharedsize);
+	table_parallelscan_initialize(heap,
+								  ParallelTableScanFromParallelBuildShared(shared),
+								  snapshot);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUILD_SHARED, shared);
+
+	leader = (ParallelBuildLeader *) palloc0(sizeof(ParallelBuildLeader));
+
+	/*
+	 * Store shared tuplesort-private state, for which we reserved space.
+	 * Then, initialize opaque state using tuplesort routine.
+	 */
+	for (int i = 0; i < nsorts; i++)
+	{
+		Sharedsort *sharedsort;
+
+		sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+		tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+									pcxt->seg);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT + i, sharedsort);
+		leader->sharedsort[i] = sharedsort;
+	}
+
+	/* Store query string for workers */
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	/*
+	 * Allocate space for each worker's WalUsage and BufferUsage; no need to
+	 * initialize.
+	 */
+	walusage = shm_toc_allocate(pcxt->toc,
+								mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_WAL_USAGE, walusage);
+	bufferusage = shm_toc_allocate(pcxt->toc,
+								   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUFFER_USAGE, bufferusage);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	leader->pcxt = pcxt;
+	leader->nparticipanttuplesorts = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		leader->nparticipanttuplesorts++;
+	leader->shared = shared;
+	leader->snapshot = snapshot;
+	leader->walusage = walusage;
+	leader->bufferusage = bufferusage;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		parallel_build_end(leader);
+		return NULL;
+	}
+
+	/* Join heap scan ourselves */
+	if (leaderparticipates)
+		participate(leader, arg);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+
+	return leader;
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+void
+parallel_build_end(ParallelBuildLeader *leader)
+{
+	int			i;
+
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(leader->pcxt);
+
+	/*
+	 * Next, accumulate WAL usage.  (This must wait for the workers to finish,
+	 * or we might get incomplete data.)
+	 */
+	for (i = 0; i < leader->pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&leader->bufferusage[i], &leader->walusage[i]);
+
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(leader->snapshot))
+		UnregisterSnapshot(leader->snapshot);
+	DestroyParallelContext(leader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * index build based on the snapshot its parallel scan will use.
+ */
+static Size
+parallel_build_estimate_shared(Relation heap, Snapshot snapshot,
+							   Size amsharedsize)
+{
+	/* c.f. shm_toc_allocate as to why BUFFERALIGN is used */
+	return add_size(add_size(BUFFERALIGN(sizeof(ParallelBuildShared)),
+							 BUFFERALIGN(amsharedsize)),
+					table_parallelscan_estimate(heap, snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by parallel_build_begin() will
+ * already be underway within worker processes (when leader participates
+ * as a worker, we should end up here just as workers are finishing).
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+double
+parallel_build_wait_scan(ParallelBuildLeader *leader, double *indtuples,
+						 bool *havedead, bool *brokenhotchain)
+{
+	ParallelBuildShared *shared = leader->shared;
+	double		reltuples;
+
+	for (;;)
+	{
+		SpinLockAcquire(&shared->mutex);
+		if (shared->nparticipantsdone == leader->nparticipanttuplesorts)
+		{
+			*indtuples = shared->indtuples;
+			if (havedead)
+				*havedead = shared->havedead;
+			*brokenhotchain = shared->brokenhotchain;
+			reltuples = shared->reltuples;
+			SpinLockRelease(&shared->mutex);
+			break;
+		}
+		SpinLockRelease(&shared->mutex);
+
+		ConditionVariableSleep(&shared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Set up the coordination state the leader needs for the final merge of the
+ * participants' sorted runs of its sortno'th tuplesort.
+ */
+SortCoordinate
+parallel_build_leader_coordinate(ParallelBuildLeader *leader, int sortno)
+{
+	SortCoordinate coordinate;
+
+	Assert(sortno >= 0 && sortno < leader->shared->nsorts);
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = leader->nparticipanttuplesorts;
+	coordinate->sharedsort = leader->sharedsort[sortno];
+
+	return coordinate;
+}
+
+/*
+ * Set up a launched parallel worker process.
+ *
+ * Looks up the shared state, opens the heap and index relations using the
+ * lock modes known to be obtained by index.c, and attaches to the shared
+ * tuplesorts, which are returned in sharedsort[].  The caller then performs
+ * its share of the scan and sort, and finishes by calling
+ * parallel_build_worker_end().
+ */
+ParallelBuildShared *
+parallel_build_worker_begin(dsm_segment *seg, shm_toc *toc,
+							Relation *heapRel, Relation *indexRel,
+							Sharedsort **sharedsort)
+{
+	char	   *sharedquery;
+	ParallelBuildShared *shared;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+
+	/*
+	 * The only possible status flag that can be set to the parallel worker is
+	 * PROC_IN_SAFE_IC.
+	 */
+	Assert((MyProc->statusFlags == 0) ||
+		   (MyProc->statusFlags == PROC_IN_SAFE_IC));
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up shared state */
+	shared = shm_toc_lookup(toc, PARALLEL_KEY_BUILD_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!shared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Track query ID */
+	pgstat_report_query_id(shared->queryid, false);
+
+	/* Open relations within worker */
+	*heapRel = table_open(shared->heaprelid, heapLockmode);
+	*indexRel = index_open(shared->indexrelid, indexLockmode);
+
+	/* Look up shared state private to tuplesort.c */
+	for (int i = 0; i < PARALLEL_BUILD_MAX_SORTS; i++)
+	{
+		if (i < shared->nsorts)
+		{
+			sharedsort[i] = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT + i,
+										   false);
+			tuplesort_attach_shared(sharedsort[i], seg);
+		}
+		else
+			sharedsort[i] = NULL;
+	}
+
+	/* Prepare to track buffer usage during parallel execution */
+	InstrStartParallelQuery();
+
+	return shared;
+}
+
+/*
+ * Finish up within a launched parallel worker process.
+ */
+void
+parallel_build_worker_end(shm_toc *toc, ParallelBuildShared *shared,
+						  Relation heapRel, Relation indexRel)
+{
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+
+	/* Report WAL/buffer usage during parallel execution */
+	bufferusage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
+	walusage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&bufferusage[ParallelWorkerNumber],
+						  &walusage[ParallelWorkerNumber]);
+
+	if (!shared->isconcurrent)
+	{
+		index_close(indexRel, AccessExclusiveLock);
+		table_close(heapRel, ShareLock);
+	}
+	else
+	{
+		index_close(indexRel, RowExclusiveLock);
+		table_close(heapRel, ShareUpdateExclusiveLock);
+	}
+}
+
+/*
+ * Set up the coordination state for a participant's "partial" tuplesort.
+ */
+SortCoordinate
+parallel_build_worker_coordinate(Sharedsort *sharedsort)
+{
+	SortCoordinate coordinate;
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	return coordinate;
+}
+
+/*
+ * Perform a participant's share of the parallel heap scan, passing each
+ * tuple to callback.
+ *
+ * Returns the number of heap tuples scanned, and sets *brokenhotchain if a
+ * broken HOT chain was encountered.
+ */
+double
+parallel_build_scan(ParallelBuildShared *shared, Relation heap, Relation index,
+					bool progress, IndexBuildCallback callback,
+					void *callback_state, bool *brokenhotchain)
+{
+	IndexInfo  *indexInfo;
+	TableScanDesc scan;
+	double		reltuples;
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = shared->isconcurrent;
+	scan = table_beginscan_parallel(heap,
+									ParallelTableScanFromParallelBuildShared(shared));
+	reltuples = table_index_build_scan(heap, index, indexInfo, true, progress,
+									   callback, callback_state, scan);
+
+	*brokenhotchain = indexInfo->ii_BrokenHotChain;
+
+	return reltuples;
+}
+
+/*
+ * Report that a participant is done with its share of the scan and sort.
+ *
+ * This records its ambuild statistics, and whether it encountered a broken
+ * HOT chain, and lets the leader know.
+ */
+void
+parallel_build_scan_done(ParallelBuildShared *shared, double reltuples,
+						 double indtuples, bool havedead, bool brokenhotchain)
+{
+	SpinLockAcquire(&shared->mutex);
+	shared->nparticipantsdone++;
+	shared->reltuples += reltuples;
+	if (havedead)
+		shared->havedead = true;
+	shared->indtuples += indtuples;
+	if (brokenhotchain)
+		shared->brokenhotchain = true;
+	SpinLockRelease(&shared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&shared->workersdonecv);
+}
@@ -30,9 +30,18 @@
 /* Minimum tree height for application of fastpath optimization */
 #define BTREE_FASTPATH_MIN_LEVEL	2
 
+/*
+ * Number of misses, in excess of hits, after which a statement stops trying
+ * its leaf page cache
+ */
+#define BTREE_INSERTCACHE_MAX_MISSES	32
+
 
 static BTStack _bt_search_insert(Relation rel, Relation heaprel,
-								 BTInsertState insertstate);
+								 BTInsertState insertstate,
+								 BTInsertCache cache);
+static bool _bt_insertcache_usable(Relation rel, BTInsertState insertstate,
+								   Page page);
 static TransactionId _bt_check_unique(Relation rel, BTInsertState insertstate,
 									  Relation heapRel,
 									  IndexUniqueCheck checkUnique, bool *is_unique,
@@ -93,6 +102,9 @@ static inline int _bt_blk_cmp(const void *arg1, const void *arg2);
  *		must nevertheless have a new entry to point to a successor
  *		version.
  *
+ *		cache, if not NULL, is the caller's per-statement leaf page cache;
+ *		see _bt_search_insert().
+ *
  *		The result value is only significant for UNIQUE_CHECK_PARTIAL:
  *		it must be true if the entry is known unique, else false.
  *		(In the current implementation we'll also return true after a
@@ -102,7 +114,7 @@ static inline int _bt_blk_cmp(const void *arg1, const void *arg2);
 bool
 _bt_doinsert(Relation rel, IndexTuple itup,
 			 IndexUniqueCheck checkUnique, bool indexUnchanged,
-			 Relation heapRel)
+			 Relation heapRel, BTInsertCache cache)
 {
 	bool		is_unique = false;
 	BTInsertStateData insertstate;
@@ -165,7 +177,7 @@ search:
 	 * searching from the root page.  insertstate.buf will hold a buffer that
 	 * is locked in exclusive mode afterwards.
 	 */
-	stack = _bt_search_insert(rel, heapRel, &insertstate);
+	stack = _bt_search_insert(rel, heapRel, &insertstate, cache);
 
 	/*
 	 * checkingunique inserts are not allowed to go ahead when two tuples with
@@ -258,6 +270,23 @@ search:
 		 */
 		newitemoff = _bt_findinsertloc(rel, &insertstate, checkingunique,
 									   indexUnchanged, stack, heapRel);
+
+		/*
+		 * Remember the leaf page for the next insert of this statement.  The
+		 * rightmost leaf page is left to the relation-level cache maintained
+		 * by _bt_insertonpg().
+		 */
+		if (cache)
+		{
+			BTPageOpaque opaque;
+
+			opaque = BTPageGetOpaque(BufferGetPage(insertstate.buf));
+			if (P_RIGHTMOST(opaque))
+				cache->leafblk = InvalidBlockNumber;
+			else
+				cache->leafblk = BufferGetBlockNumber(insertstate.buf);
+		}
+
 		_bt_insertonpg(rel, heapRel, itup_key, insertstate.buf, InvalidBuffer,
 					   stack, itup, insertstate.itemsz, newitemoff,
 					   insertstate.postingoff, false);
@@ -313,9 +342,17 @@ search:
  * rightmost page (we give up if we'd have to wait for the lock).  We assume
  * that it isn't useful to apply the optimization when there is contention,
  * since each per-backend cache won't stay valid for long.
+ *
+ * A similar optimization applies to non-rightmost leaf pages, using the
+ * caller's per-statement cache of the last leaf page inserted into.  This
+ * helps when a statement inserts many tuples whose keys are clustered, even
+ * though they don't go at the end of the index.  Here we must also make sure
+ * that the new tuple is strictly less than the page's high key, so that it
+ * can't belong on a page to the right.
  */
 static BTStack
-_bt_search_insert(Relation rel, Relation heaprel, BTInsertState insertstate)
+_bt_search_insert(Relation rel, Relation heaprel, BTInsertState insertstate,
+				  BTInsertCache cache)
 {
 	Assert(insertstate->buf == InvalidBuffer);
 	Assert(!insertstate->bounds_valid);
@@ -376,12 +413,80 @@ _bt_search_insert(Relation rel, Relation heaprel, BTInsertState insertstate)
 		/* Forget block, since cache doesn't appear to be useful */
 		RelationSetTargetBlock(rel, InvalidBlockNumber);
 	}
+	else if (cache && BlockNumberIsValid(cache->leafblk) &&
+			 cache->nmisses < cache->nhits + BTREE_INSERTCACHE_MAX_MISSES)
+	{
+		/* Simulate a _bt_getbuf() call with conditional locking */
+		insertstate->buf = ReadBuffer(rel, cache->leafblk);
+		if (_bt_conditionallockbuf(rel, insertstate->buf))
+		{
+			_bt_checkpage(rel, insertstate->buf);
+
+			if (_bt_insertcache_usable(rel, insertstate,
+									   BufferGetPage(insertstate->buf)))
+			{
+				/* Use the cached page, with a NULL stack as above */
+				cache->nhits++;
+				return NULL;
+			}
+
+			/* Page unsuitable for caller, drop lock and pin */
+			_bt_relbuf(rel, insertstate->buf);
+		}
+		else
+		{
+			/* Lock unavailable, drop pin */
+			ReleaseBuffer(insertstate->buf);
+		}
+
+		/* Count the miss; the block will be replaced after the descent */
+		cache->nmisses++;
+		cache->leafblk = InvalidBlockNumber;
+	}
 
 	/* Cannot use optimization -- descend tree, return proper descent stack */
 	return _bt_search(rel, heaprel, insertstate->itup_key, &insertstate->buf,
 					  BT_WRITE);
 }
 
+/*
+ * Can the new tuple go on the locked leaf page from the per-statement cache,
+ * without descending the tree?
+ *
+ * The page must still be a live leaf page that isn't the root, isn't in the
+ * middle of a split, and can fit the new tuple without splitting.  The
+ * insertion scan key must be strictly greater than the first non-pivot tuple
+ * (so no page to the left could hold it or an equal key) and, unless the
+ * page is rightmost, strictly less than the high key (so no page to the
+ * right could either).  The latter ensures that _bt_findinsertloc() never
+ * needs to step right, which it could not do properly without a stack.
+ * We only do this for heapkeyspace indexes, for the same reason.
+ */
+static bool
+_bt_insertcache_usable(Relation rel, BTInsertState insertstate, Page page)
+{
+	BTPageOpaque opaque = BTPageGetOpaque(page);
+	BTScanInsert itup_key = insertstate->itup_key;
+
+	if (!itup_key->heapkeyspace ||
+		!P_ISLEAF(opaque) || P_ISROOT(opaque) || P_IGNORE(opaque) ||
+		P_INCOMPLETE_SPLIT(opaque))
+		return false;
+
+	if (PageGetFreeSpace(page) <= insertstate->itemsz ||
+		PageGetMaxOffsetNumber(page) < P_FIRSTDATAKEY(opaque))
+		return false;
+
+	if (_bt_compare(rel, itup_key, page, P_FIRSTDATAKEY(opaque)) <= 0)
+		return false;
+
+	if (!P_RIGHTMOST(opaque) &&
+		_bt_compare(rel, itup_key, page, P_HIKEY) >= 0)
+		return false;
+
+	return true;
+}
+
 /*
  *	_bt_check_unique() -- Check for violation of unique index constraint
  *
@@ -144,6 +144,7 @@ bthandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = btbuild;
 	amroutine->ambuildempty = btbuildempty;
+	amroutine->ambuildusesworkers = NULL;
 	amroutine->aminsert = btinsert;
 	amroutine->aminsertcleanup = NULL;
 	amroutine->ambulkdelete = btbulkdelete;
@@ -207,12 +208,30 @@ btinsert(Relation rel, Datum *values, bool *isnull,
 {
 	bool		result;
 	IndexTuple	itup;
+	BTInsertCache cache = NULL;
+
+	/*
+	 * Set up the per-statement leaf page cache, if first time through in this
+	 * statement
+	 */
+	if (indexInfo)
+	{
+		cache = (BTInsertCache) indexInfo->ii_AmCache;
+		if (cache == NULL)
+		{
+			cache = MemoryContextAllocZero(indexInfo->ii_Context,
+										   sizeof(BTInsertCacheData));
+			cache->leafblk = InvalidBlockNumber;
+			indexInfo->ii_AmCache = cache;
+		}
+	}
 
 	/* generate an index tuple */
 	itup = index_form_tuple(RelationGetDescr(rel), values, isnull);
 	itup->t_tid = *ht_ctid;
 
-	result = _bt_doinsert(rel, itup, checkUnique, indexUnchanged, heapRel);
+	result = _bt_doinsert(rel, itup, checkUnique, indexUnchanged, heapRel,
+						  cache);
 
 	pfree(itup);
 
@@ -18,6 +18,8 @@
 #include "access/nbtree.h"
 #include "access/relscan.h"
 #include "access/xact.h"
+#include "catalog/pg_opfamily_d.h"
+#include "catalog/pg_type_d.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/predicate.h"
@@ -25,11 +27,31 @@
 #include "utils/rel.h"
 
 
+/*
+ * Interpolation search is used for at most BT_INTERP_MAX_PROBES probes per
+ * page, and only while at least BT_INTERP_MIN_ITEMS slots remain to search.
+ * Plain binary search takes over after that, which bounds the damage done
+ * by skewed key distributions.
+ */
+#define BT_INTERP_MAX_PROBES	3
+#define BT_INTERP_MIN_ITEMS		8
+
 static inline void _bt_drop_lock_and_maybe_pin(Relation rel, BTScanOpaque so);
 static Buffer _bt_moveright(Relation rel, Relation heaprel, BTScanInsert key,
 							Buffer buf, bool forupdate, BTStack stack,
 							int access);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
+static inline int32 _bt_compare_prefix(Relation rel, BTScanInsert key,
+									   Page page, OffsetNumber offnum,
+									   int skipatts, int *eqatts);
+static Oid	_bt_interp_keytype(Relation rel, BTScanInsert key, int64 *keyval);
+static inline bool _bt_interp_getval(Relation rel, Page page,
+									 OffsetNumber offnum, Oid typid,
+									 int64 *val);
+static OffsetNumber _bt_interp_mid(Relation rel, Page page,
+								   OffsetNumber low, OffsetNumber high,
+								   OffsetNumber minusinf, Oid typid,
+								   int64 keyval);
 static int	_bt_binsrch_posting(BTScanInsert key, Page page,
 								OffsetNumber offnum);
 static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
@@ -355,6 +377,11 @@ _bt_binsrch(Relation rel,
 				high;
 	int32		result,
 				cmpval;
+	int			lowprefix,
+				highprefix;
+	Oid			interptype;
+	int64		interpval;
+	int			interpprobes;
 
 	page = BufferGetPage(buf);
 	opaque = BTPageGetOpaque(page);
@@ -388,23 +415,63 @@ _bt_binsrch(Relation rel,
 	 * 'low' are <= scan key, all slots at or after 'high' are > scan key.
 	 *
 	 * We can fall out when high == low.
+	 *
+	 * We also track how many leading key attributes of the tuples just
+	 * before 'low' and at 'high' were found to be equal to the scan key.
+	 * Every tuple in between sorts between those two, so it must have at
+	 * least the smaller of those prefixes equal to the scan key too, and
+	 * _bt_compare_prefix() can skip comparing those attributes.  This makes
+	 * the search considerably cheaper on multi-column indexes whose leading
+	 * columns have few distinct values within a page.
 	 */
 	high++;						/* establish the loop invariant for high */
 
 	cmpval = key->nextkey ? 0 : 1;	/* select comparison value */
 
+	lowprefix = highprefix = 0;
+
+	/*
+	 * When the index has interpolation_search enabled and its first key
+	 * column is an integer or datetime type, the first few probes can be
+	 * placed by interpolating between the key values at the ends of the
+	 * remaining range, rather than at its midpoint.  Any probe within the
+	 * range preserves the invariants, so this only affects how fast we
+	 * converge.
+	 */
+	interptype = _bt_interp_keytype(rel, key, &interpval);
+	interpprobes = OidIsValid(interptype) ? BT_INTERP_MAX_PROBES : 0;
+
 	while (high > low)
 	{
-		OffsetNumber mid = low + ((high - low) / 2);
+		OffsetNumber mid;
+		int			eqatts;
+
+		if (interpprobes > 0)
+		{
+			interpprobes--;
+			mid = _bt_interp_mid(rel, page, low, high,
+								 P_ISLEAF(opaque) ? InvalidOffsetNumber :
+								 P_FIRSTDATAKEY(opaque),
+								 interptype, interpval);
+		}
+		else
+			mid = low + ((high - low) / 2);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid,
+									Min(lowprefix, highprefix), &eqatts);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowprefix = eqatts;
+		}
 		else
+		{
 			high = mid;
+			highprefix = eqatts;
+		}
 	}
 
 	/*
@@ -486,6 +553,11 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 				stricthigh;
 	int32		result,
 				cmpval;
+	int			lowprefix,
+				highprefix;
+	Oid			interptype;
+	int64		interpval;
+	int			interpprobes;
 
 	page = BufferGetPage(insertstate->buf);
 	opaque = BTPageGetOpaque(page);
@@ -526,6 +598,10 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 	 * maintained to save additional search effort for caller.
 	 *
 	 * We can fall out when high == low.
+	 *
+	 * Equal key prefixes are tracked and skipped in the same way as in
+	 * _bt_binsrch().  We don't know the prefixes of cached bounds, so they
+	 * start out at zero either way.
 	 */
 	if (!insertstate->bounds_valid)
 		high++;					/* establish the loop invariant for high */
@@ -533,19 +609,40 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 
 	cmpval = 1;					/* !nextkey comparison value */
 
+	lowprefix = highprefix = 0;
+
+	/* Interpolate the first few probes where possible, as _bt_binsrch() */
+	interptype = _bt_interp_keytype(rel, key, &interpval);
+	interpprobes = OidIsValid(interptype) ? BT_INTERP_MAX_PROBES : 0;
+
 	while (high > low)
 	{
-		OffsetNumber mid = low + ((high - low) / 2);
+		OffsetNumber mid;
+		int			eqatts;
+
+		if (interpprobes > 0)
+		{
+			interpprobes--;
+			mid = _bt_interp_mid(rel, page, low, high, InvalidOffsetNumber,
+								 interptype, interpval);
+		}
+		else
+			mid = low + ((high - low) / 2);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid,
+									Min(lowprefix, highprefix), &eqatts);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowprefix = eqatts;
+		}
 		else
 		{
 			high = mid;
+			highprefix = eqatts;
 			if (result != 0)
 				stricthigh = high;
 		}
@@ -595,6 +692,146 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 	return low;
 }
 
+/*
+ *	_bt_interp_keytype() -- can we use interpolation search for this key?
+ *
+ * Interpolation is only used when the index's interpolation_search storage
+ * parameter is enabled.  It helps when the keys on a page are spread evenly
+ * and costs extra comparisons when they are not, and only the user knows
+ * which is the case.
+ *
+ * Interpolation needs the first key column's values to map onto integers in
+ * a way that preserves the index order.  That's true of the integer types,
+ * and of the date and timestamp types, when compared using the core btree
+ * opfamilies.  Cross-type comparisons, descending columns, and NULL or
+ * sentinel scan key values are not handled.
+ *
+ * Returns the column's type and sets *keyval to the scan key's value, or
+ * returns InvalidOid if interpolation can't be used.
+ */
+static Oid
+_bt_interp_keytype(Relation rel, BTScanInsert key, int64 *keyval)
+{
+	ScanKey		skey = key->scankeys;
+	Oid			typid;
+
+	if (!BTGetInterpolationSearch(rel))
+		return InvalidOid;
+
+	if (key->keysz < 1 ||
+		(skey->sk_flags & (SK_ISNULL | SK_BT_DESC |
+						   SK_BT_MINVAL | SK_BT_MAXVAL)) != 0)
+		return InvalidOid;
+
+	if (rel->rd_opfamily[0] != INTEGER_BTREE_FAM_OID &&
+		rel->rd_opfamily[0] != DATETIME_BTREE_FAM_OID)
+		return InvalidOid;
+
+	typid = rel->rd_opcintype[0];
+	if (skey->sk_subtype != typid && skey->sk_subtype != InvalidOid)
+		return InvalidOid;
+
+	switch (typid)
+	{
+		case INT2OID:
+			*keyval = DatumGetInt16(skey->sk_argument);
+			break;
+		case INT4OID:
+		case DATEOID:
+			*keyval = DatumGetInt32(skey->sk_argument);
+			break;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			*keyval = DatumGetInt64(skey->sk_argument);
+			break;
+		default:
+			return InvalidOid;
+	}
+
+	return typid;
+}
+
+/*
+ * Fetch the first key column of the tuple at offnum as an integer.  Returns
+ * false if it's NULL or has been truncated away.
+ */
+static inline bool
+_bt_interp_getval(Relation rel, Page page, OffsetNumber offnum, Oid typid,
+				  int64 *val)
+{
+	IndexTuple	itup;
+	Datum		datum;
+	bool		isnull;
+
+	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	if (BTreeTupleGetNAtts(itup, rel) < 1)
+		return false;
+
+	datum = index_getattr(itup, 1, RelationGetDescr(rel), &isnull);
+	if (isnull)
+		return false;
+
+	switch (typid)
+	{
+		case INT2OID:
+			*val = DatumGetInt16(datum);
+			break;
+		case INT4OID:
+		case DATEOID:
+			*val = DatumGetInt32(datum);
+			break;
+		default:
+			*val = DatumGetInt64(datum);
+			break;
+	}
+
+	return true;
+}
+
+/*
+ *	_bt_interp_mid() -- choose the next probe of a binary search by
+ *	interpolation.
+ *
+ * Returns an offset in [low, high), estimated from the first key column
+ * values of the tuples at the ends of that range.  minusinf is the offset
+ * of an internal page's "minus infinity" item (which has no key values), or
+ * InvalidOffsetNumber.  Falls back to the midpoint when the range is small
+ * or the end values can't be used.
+ */
+static OffsetNumber
+_bt_interp_mid(Relation rel, Page page, OffsetNumber low, OffsetNumber high,
+			   OffsetNumber minusinf, Oid typid, int64 keyval)
+{
+	OffsetNumber midpoint = low + ((high - low) / 2);
+	OffsetNumber first = low;
+	OffsetNumber last = high - 1;
+	int64		firstval;
+	int64		lastval;
+	double		frac;
+
+	if (high - low < BT_INTERP_MIN_ITEMS)
+		return midpoint;
+
+	if (first == minusinf)
+		first++;
+
+	if (!_bt_interp_getval(rel, page, first, typid, &firstval) ||
+		!_bt_interp_getval(rel, page, last, typid, &lastval))
+		return midpoint;
+
+	if (keyval <= firstval)
+		return first;
+	if (keyval >= lastval)
+		return last;
+
+	/* firstval < keyval < lastval here */
+	frac = ((double) keyval - (double) firstval) /
+		((double) lastval - (double) firstval);
+
+	return first + (OffsetNumber) (frac * (last - first));
+}
+
 /*----------
  *	_bt_binsrch_posting() -- posting list binary search.
  *
@@ -694,6 +931,26 @@ _bt_compare(Relation rel,
 			BTScanInsert key,
 			Page page,
 			OffsetNumber offnum)
+{
+	return _bt_compare_prefix(rel, key, page, offnum, 0, NULL);
+}
+
+/*
+ *	_bt_compare_prefix() -- _bt_compare(), skipping known-equal attributes.
+ *
+ * Caller asserts that the first 'skipatts' key attributes of the tuple at
+ * offnum are equal to the scankey, so those aren't compared again.  If
+ * 'eqatts' isn't NULL, it is set to the number of leading key attributes
+ * that are known to be equal to the scankey after the comparison (the
+ * skipped attributes included).  Heap TID is not counted.
+ */
+static pg_attribute_always_inline int32
+_bt_compare_prefix(Relation rel,
+				   BTScanInsert key,
+				   Page page,
+				   OffsetNumber offnum,
+				   int skipatts,
+				   int *eqatts)
 {
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = BTPageGetOpaque(page);
@@ -713,7 +970,11 @@ _bt_compare(Relation rel,
 	 * --- see NOTE above.
 	 */
 	if (!P_ISLEAF(opaque) && offnum == P_FIRSTDATAKEY(opaque))
+	{
+		if (eqatts)
+			*eqatts = 0;
 		return 1;
+	}
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
 	ntupatts = BTreeTupleGetNAtts(itup, rel);
@@ -733,8 +994,10 @@ _bt_compare(Relation rel,
 	ncmpkey = Min(ntupatts, key->keysz);
 	Assert(key->heapkeyspace || ncmpkey == key->keysz);
 	Assert(!BTreeTupleIsPosting(itup) || key->allequalimage);
-	scankey = key->scankeys;
-	for (int i = 1; i <= ncmpkey; i++)
+	Assert(skipatts >= 0 && skipatts <= ncmpkey);
+	skipatts = Min(skipatts, ncmpkey);
+	scankey = key->scankeys + skipatts;
+	for (int i = skipatts + 1; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -778,11 +1041,18 @@ _bt_compare(Relation rel,
 
 		/* if the keys are unequal, return the difference */
 		if (result != 0)
+		{
+			if (eqatts)
+				*eqatts = i - 1;
 			return result;
+		}
 
 		scankey++;
 	}
 
+	if (eqatts)
+		*eqatts = ncmpkey;
+
 	/*
 	 * All non-truncated attributes (other than heap TID) were found to be
 	 * equal.  Treat truncated attributes as minus infinity when scankey has a
@@ -3793,7 +3793,9 @@ btoptions(Datum reloptions, bool validate)
 		{"vacuum_cleanup_index_scale_factor", RELOPT_TYPE_REAL,
 		offsetof(BTOptions, vacuum_cleanup_index_scale_factor)},
 		{"deduplicate_items", RELOPT_TYPE_BOOL,
-		offsetof(BTOptions, deduplicate_items)}
+		offsetof(BTOptions, deduplicate_items)},
+		{"interpolation_search", RELOPT_TYPE_BOOL,
+		offsetof(BTOptions, interpolation_search)}
 	};
 
 	return (bytea *) build_reloptions(reloptions, validate,
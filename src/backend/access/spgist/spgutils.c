@@ -73,6 +73,7 @@ spghandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = spgbuild;
 	amroutine->ambuildempty = spgbuildempty;
+	amroutine->ambuildusesworkers = NULL;
 	amroutine->aminsert = spginsert;
 	amroutine->aminsertcleanup = NULL;
 	amroutine->ambulkdelete = spgbulkdelete;
@@ -16,6 +16,8 @@
 
 #include "access/brin.h"
 #include "access/gin.h"
+#include "access/gist.h"
+#include "access/hash.h"
 #include "access/nbtree.h"
 #include "access/parallel.h"
 #include "access/session.h"
@@ -152,6 +154,12 @@ static const struct
 	{
 		"_gin_parallel_build_main", _gin_parallel_build_main
 	},
+	{
+		"_gist_parallel_build_main", _gist_parallel_build_main
+	},
+	{
+		"_hash_parallel_build_main", _hash_parallel_build_main
+	},
 	{
 		"parallel_vacuum_main", parallel_vacuum_main
 	}
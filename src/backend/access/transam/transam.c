@@ -25,14 +25,34 @@
 #include "utils/snapmgr.h"
 
 /*
- * Single-item cache for results of TransactionLogFetch.  It's worth having
+ * Backend-local cache for results of TransactionLogFetch.  It's worth having
  * such a cache because we frequently find ourselves repeatedly checking the
- * same XID, for example when scanning a table just after a bulk insert,
- * update, or delete.
+ * same XIDs, for example when scanning a table just after a bulk insert,
+ * update, or delete.  Checking the clog requires a trip through the SLRU and
+ * its bank locks, so even a small cache saves a lot of work.
+ *
+ * The cache is direct-mapped on the low bits of the XID.  That keeps lookups
+ * to a single probe, and since XIDs are assigned sequentially, a run of
+ * recently finished transactions (as is typical for the xmin and xmax values
+ * found on a freshly loaded page) occupies distinct slots instead of
+ * evicting each other, as a single-item cache would.
+ *
+ * Only final states (committed or aborted) are ever cached, so entries never
+ * need to be invalidated.
  */
-static TransactionId cachedFetchXid = InvalidTransactionId;
-static XidStatus cachedFetchXidStatus;
-static XLogRecPtr cachedCommitLSN;
+#define XID_STATUS_CACHE_SIZE	64
+
+typedef struct XidStatusCacheEntry
+{
+	TransactionId xid;
+	XidStatus	status;
+	XLogRecPtr	lsn;
+} XidStatusCacheEntry;
+
+static XidStatusCacheEntry xidStatusCache[XID_STATUS_CACHE_SIZE];
+
+#define XidStatusCacheSlot(xid) \
+	(&xidStatusCache[(xid) % XID_STATUS_CACHE_SIZE])
 
 /* Local functions */
 static XidStatus TransactionLogFetch(TransactionId transactionId);
@@ -51,18 +71,14 @@ static XidStatus TransactionLogFetch(TransactionId transactionId);
 static XidStatus
 TransactionLogFetch(TransactionId transactionId)
 {
+	XidStatusCacheEntry *entry;
 	XidStatus	xidstatus;
 	XLogRecPtr	xidlsn;
 
 	/*
-	 * Before going to the commit log manager, check our single item cache to
-	 * see if we didn't just check the transaction status a moment ago.
-	 */
-	if (TransactionIdEquals(transactionId, cachedFetchXid))
-		return cachedFetchXidStatus;
-
-	/*
-	 * Also, check to see if the transaction ID is a permanent one.
+	 * Check to see if the transaction ID is a permanent one.  This must come
+	 * before the cache lookup, since slots that have never been filled hold
+	 * InvalidTransactionId.
 	 */
 	if (!TransactionIdIsNormal(transactionId))
 	{
@@ -73,6 +89,14 @@ TransactionLogFetch(TransactionId transactionId)
 		return TRANSACTION_STATUS_ABORTED;
 	}
 
+	/*
+	 * Before going to the commit log manager, check our cache to see if we
+	 * didn't recently check the transaction status already.
+	 */
+	entry = XidStatusCacheSlot(transactionId);
+	if (TransactionIdEquals(transactionId, entry->xid))
+		return entry->status;
+
 	/*
 	 * Get the transaction status.
 	 */
@@ -85,9 +109,9 @@ TransactionLogFetch(TransactionId transactionId)
 	if (xidstatus != TRANSACTION_STATUS_IN_PROGRESS &&
 		xidstatus != TRANSACTION_STATUS_SUB_COMMITTED)
 	{
-		cachedFetchXid = transactionId;
-		cachedFetchXidStatus = xidstatus;
-		cachedCommitLSN = xidlsn;
+		entry->xid = transactionId;
+		entry->status = xidstatus;
+		entry->lsn = xidlsn;
 	}
 
 	return xidstatus;
@@ -317,20 +341,22 @@ TransactionIdLatest(TransactionId mainxid,
 XLogRecPtr
 TransactionIdGetCommitLSN(TransactionId xid)
 {
+	XidStatusCacheEntry *entry;
 	XLogRecPtr	result;
 
+	/* Special XIDs are always known committed */
+	if (!TransactionIdIsNormal(xid))
+		return InvalidXLogRecPtr;
+
 	/*
 	 * Currently, all uses of this function are for xids that were just
 	 * reported to be committed by TransactionLogFetch, so we expect that
 	 * checking TransactionLogFetch's cache will usually succeed and avoid an
 	 * extra trip to shared memory.
 	 */
-	if (TransactionIdEquals(xid, cachedFetchXid))
-		return cachedCommitLSN;
-
-	/* Special XIDs are always known committed */
-	if (!TransactionIdIsNormal(xid))
-		return InvalidXLogRecPtr;
+	entry = XidStatusCacheSlot(xid);
+	if (TransactionIdEquals(xid, entry->xid))
+		return entry->lsn;
 
 	/*
 	 * Get the transaction status.
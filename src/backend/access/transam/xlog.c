@@ -673,6 +673,7 @@ static XLogRecPtr XLogGetReplicationSlotMinimumLSN(void);
 static void AdvanceXLInsertBuffer(XLogRecPtr upto, TimeLineID tli,
 								  bool opportunistic);
 static void XLogWrite(XLogwrtRqst WriteRqst, TimeLineID tli, bool flexible);
+static void XLogWriteBack(XLogRecPtr start, XLogRecPtr end);
 static bool InstallXLogFileSegment(XLogSegNo *segno, char *tmppath,
 								   bool find_free, XLogSegNo max_segno,
 								   TimeLineID tli);
@@ -2603,6 +2604,34 @@ XLogWrite(XLogwrtRqst WriteRqst, TimeLineID tli, bool flexible)
 #endif
 }
 
+/*
+ * Initiate write-back of already written, but not yet flushed, WAL between
+ * 'start' and 'end' in the currently open WAL segment.
+ *
+ * This only asks the kernel to start writing the data out; it does not wait
+ * for it to reach durable storage, so it is not a substitute for
+ * issue_xlog_fsync().  The range must lie within openLogSegNo.
+ */
+static void
+XLogWriteBack(XLogRecPtr start, XLogRecPtr end)
+{
+	/* Nothing to do if write() already synced the data */
+	if (wal_sync_method == WAL_SYNC_METHOD_OPEN ||
+		wal_sync_method == WAL_SYNC_METHOD_OPEN_DSYNC)
+		return;
+
+	if (openLogFile < 0 ||
+		!XLByteInSeg(start, openLogSegNo, wal_segment_size) ||
+		!XLByteInPrevSeg(end, openLogSegNo, wal_segment_size))
+		return;
+
+	pgstat_report_wait_start(WAIT_EVENT_WAL_WRITEBACK);
+	pg_flush_data(openLogFile,
+				  XLogSegmentOffset(start, wal_segment_size),
+				  end - start);
+	pgstat_report_wait_end();
+}
+
 /*
  * Record the LSN for an asynchronous transaction commit/abort
  * and nudge the WALWriter if there is work for it to do.
@@ -2983,6 +3012,7 @@ XLogBackgroundFlush(void)
 	TimestampTz now;
 	int			flushblocks;
 	TimeLineID	insertTLI;
+	XLogRecPtr	prevWrite;
 
 	/* XLOG doesn't need flushing during recovery */
 	if (RecoveryInProgress())
@@ -3085,6 +3115,7 @@ XLogBackgroundFlush(void)
 	WaitXLogInsertionsToFinish(WriteRqst.Write);
 	LWLockAcquire(WALWriteLock, LW_EXCLUSIVE);
 	RefreshXLogWriteResult(LogwrtResult);
+	prevWrite = LogwrtResult.Write;
 	if (WriteRqst.Write > LogwrtResult.Write ||
 		WriteRqst.Flush > LogwrtResult.Flush)
 	{
@@ -3094,6 +3125,19 @@ XLogBackgroundFlush(void)
 
 	END_CRIT_SECTION();
 
+	/*
+	 * If we only wrote WAL without flushing it, ask the kernel to start
+	 * writeback of the newly written range right away.  That keeps the
+	 * device busy while backends continue to insert, and leaves less dirty
+	 * data for the fdatasync() that follows once wal_writer_delay or
+	 * wal_writer_flush_after is reached, shortening the time WALWriteLock is
+	 * held for it.  This is done after releasing the lock, since
+	 * openLogFile is private to this process.
+	 */
+	if (LogwrtResult.Flush < LogwrtResult.Write &&
+		LogwrtResult.Write > prevWrite)
+		XLogWriteBack(Max(prevWrite, LogwrtResult.Flush), LogwrtResult.Write);
+
 	/* wake up walsenders now that we've released heavily contended locks */
 	WalSndWakeupProcessRequests(true, !RecoveryInProgress());
 
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 
+#include "access/printtup.h"
 #include "access/table.h"
 #include "access/tableam.h"
 #include "catalog/pg_inherits.h"
@@ -365,13 +366,8 @@ CopyToBinaryOneRow(CopyToState cstate, TupleTableSlot *slot)
 		}
 		else
 		{
-			bytea	   *outputbytes;
-
-			outputbytes = SendFunctionCall(&out_functions[attnum - 1],
-										   value);
-			CopySendInt32(cstate, VARSIZE(outputbytes) - VARHDRSZ);
-			CopySendData(cstate, VARDATA(outputbytes),
-						 VARSIZE(outputbytes) - VARHDRSZ);
+			SendBinaryAttribute(cstate->fe_msgbuf,
+								&out_functions[attnum - 1], value);
 		}
 	}
 
@@ -13,6 +13,7 @@
  */
 #include "postgres.h"
 
+#include "access/printtup.h"
 #include "commands/explain.h"
 #include "commands/explain_dr.h"
 #include "commands/explain_state.h"
@@ -165,12 +166,7 @@ serializeAnalyzeReceive(TupleTableSlot *slot, DestReceiver *self)
 		else
 		{
 			/* Binary output */
-			bytea	   *outputbytes;
-
-			outputbytes = SendFunctionCall(finfo, attr);
-			pq_sendint32(buf, VARSIZE(outputbytes) - VARHDRSZ);
-			pq_sendbytes(buf, VARDATA(outputbytes),
-						 VARSIZE(outputbytes) - VARHDRSZ);
+			SendBinaryAttribute(buf, finfo, attr);
 		}
 	}
 
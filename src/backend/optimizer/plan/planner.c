@@ -6951,7 +6951,7 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
  *
  * tableOid is the table on which the index is to be built.  indexOid is the
  * OID of an index to be created or reindexed (which must be an index with
- * support for parallel builds - currently btree, GIN, or BRIN).
+ * support for parallel builds - currently btree, GIN, BRIN, GiST, or hash).
  *
  * Return value is the number of parallel worker processes to request.  It
  * may be unsafe to proceed if this is 0.  Note that this does not include the
@@ -7041,6 +7041,18 @@ plan_create_index_workers(Oid tableOid, Oid indexOid)
 		goto done;
 	}
 
+	/*
+	 * Some index AMs only use parallel workers for some of their builds (for
+	 * example, when the build is going to sort).  Don't request any workers
+	 * if the AM says it won't use them.
+	 */
+	if (index->rd_indam->ambuildusesworkers != NULL &&
+		!index->rd_indam->ambuildusesworkers(heap, index))
+	{
+		parallel_workers = 0;
+		goto done;
+	}
+
 	/*
 	 * If parallel_workers storage parameter is set for the table, accept that
 	 * as the number of parallel worker processes to launch (though still cap
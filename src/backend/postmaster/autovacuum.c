@@ -196,6 +196,16 @@ typedef struct av_relation
 								 * reloptions, or NULL if none */
 } av_relation;
 
+/*
+ * struct to keep track of tables that need vacuum to prevent wraparound, in
+ * the 1st and 2nd passes
+ */
+typedef struct av_wraparound_table
+{
+	Oid			awt_relid;
+	uint32		awt_age;		/* larger of relfrozenxid and relminmxid age */
+} av_wraparound_table;
+
 /* struct to keep track of tables to vacuum and/or analyze, after rechecking */
 typedef struct autovac_table
 {
@@ -272,6 +282,12 @@ typedef struct AutoVacuumWorkItem
 
 #define NUM_WORKITEMS	256
 
+/*
+ * At most this many work items may be BRIN resummarization requests, so that
+ * they can't crowd out summarization of newly filled ranges.
+ */
+#define MAX_RESUMMARIZE_WORKITEMS	(NUM_WORKITEMS / 4)
+
 /*-------------
  * The main autovacuum shmem struct.  On shared memory we store this main
  * struct and the array of WorkerInfo structs.  This struct keeps:
@@ -335,6 +351,9 @@ static void launch_worker(TimestampTz now);
 static List *get_database_list(void);
 static void rebuild_database_list(Oid newdb);
 static int	db_comparator(const void *a, const void *b);
+static int	wraparound_table_comparator(const ListCell *a, const ListCell *b);
+static void remember_wraparound_table(List **wraparound_tables,
+									  Form_pg_class classForm);
 static void autovac_recalculate_workers_for_balance(void);
 
 static void do_autovacuum(void);
@@ -1089,6 +1108,41 @@ db_comparator(const void *a, const void *b)
 					  ((const avl_dbase *) b)->adl_score);
 }
 
+/* list_sort comparator for av_wraparound_table, oldest first */
+static int
+wraparound_table_comparator(const ListCell *a, const ListCell *b)
+{
+	const av_wraparound_table *wa = lfirst(a);
+	const av_wraparound_table *wb = lfirst(b);
+
+	return pg_cmp_u32(wb->awt_age, wa->awt_age);
+}
+
+/*
+ * remember_wraparound_table
+ *		Add a table that needs vacuuming to prevent wraparound to the list,
+ *		along with how close it is to wraparound.
+ *
+ * Both XIDs and MultiXactIds wrap around after 2^31 values, so the larger of
+ * the two ages tells us how urgent the vacuum is.
+ */
+static void
+remember_wraparound_table(List **wraparound_tables, Form_pg_class classForm)
+{
+	av_wraparound_table *table;
+	uint32		age = 0;
+
+	if (TransactionIdIsNormal(classForm->relfrozenxid))
+		age = recentXid - classForm->relfrozenxid;
+	if (MultiXactIdIsValid(classForm->relminmxid))
+		age = Max(age, recentMulti - classForm->relminmxid);
+
+	table = palloc_object(av_wraparound_table);
+	table->awt_relid = classForm->oid;
+	table->awt_age = age;
+	*wraparound_tables = lappend(*wraparound_tables, table);
+}
+
 /*
  * do_start_worker
  *
@@ -1903,6 +1957,7 @@ do_autovacuum(void)
 	TableScanDesc relScan;
 	Form_pg_database dbForm;
 	List	   *table_oids = NIL;
+	List	   *wraparound_tables = NIL;
 	List	   *orphan_oids = NIL;
 	HASHCTL		ctl;
 	HTAB	   *table_toast_map;
@@ -2056,8 +2111,13 @@ do_autovacuum(void)
 								  effective_multixact_freeze_max_age,
 								  &dovacuum, &doanalyze, &wraparound);
 
-		/* Relations that need work are added to table_oids */
-		if (dovacuum || doanalyze)
+		/*
+		 * Relations that need work are added to table_oids, or to
+		 * wraparound_tables if they must be vacuumed to prevent wraparound.
+		 */
+		if (dovacuum && wraparound)
+			remember_wraparound_table(&wraparound_tables, classForm);
+		else if (dovacuum || doanalyze)
 			table_oids = lappend_oid(table_oids, relid);
 
 		/*
@@ -2149,7 +2209,9 @@ do_autovacuum(void)
 								  &dovacuum, &doanalyze, &wraparound);
 
 		/* ignore analyze for toast tables */
-		if (dovacuum)
+		if (dovacuum && wraparound)
+			remember_wraparound_table(&wraparound_tables, classForm);
+		else if (dovacuum)
 			table_oids = lappend_oid(table_oids, relid);
 
 		/* Release stuff to avoid leakage */
@@ -2162,6 +2224,24 @@ do_autovacuum(void)
 	table_endscan(relScan);
 	table_close(classRel, AccessShareLock);
 
+	/*
+	 * Process the tables that need vacuuming to prevent wraparound before any
+	 * others, and the ones closest to wraparound first.  When many large
+	 * tables cross their freeze limit at about the same time, this makes sure
+	 * the most urgent ones aren't stuck behind routine work or behind tables
+	 * that merely happen to come first in pg_class.
+	 */
+	if (wraparound_tables != NIL)
+	{
+		List	   *wraparound_oids = NIL;
+
+		list_sort(wraparound_tables, wraparound_table_comparator);
+		foreach_ptr(av_wraparound_table, table, wraparound_tables)
+			wraparound_oids = lappend_oid(wraparound_oids, table->awt_relid);
+		table_oids = list_concat(wraparound_oids, table_oids);
+		list_free_deep(wraparound_tables);
+	}
+
 	/*
 	 * Recheck orphan temporary tables, and if they still seem orphaned, drop
 	 * them.  We'll eat a transaction per dropped table, which might seem
@@ -2677,6 +2757,14 @@ perform_work_item(AutoVacuumWorkItem *workitem)
 									ObjectIdGetDatum(workitem->avw_relation),
 									Int64GetDatum((int64) workitem->avw_blockNumber));
 				break;
+			case AVW_BRINResummarizeRange:
+				DirectFunctionCall2(brin_desummarize_range,
+									ObjectIdGetDatum(workitem->avw_relation),
+									Int64GetDatum((int64) workitem->avw_blockNumber));
+				DirectFunctionCall2(brin_summarize_range,
+									ObjectIdGetDatum(workitem->avw_relation),
+									Int64GetDatum((int64) workitem->avw_blockNumber));
+				break;
 			default:
 				elog(WARNING, "unrecognized work item found: type %d",
 					 workitem->avw_type);
@@ -3284,6 +3372,10 @@ autovac_report_workitem(AutoVacuumWorkItem *workitem,
 			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
 					 "autovacuum: BRIN summarize");
 			break;
+		case AVW_BRINResummarizeRange:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: BRIN resummarize");
+			break;
 	}
 
 	/*
@@ -3327,10 +3419,42 @@ AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 					  BlockNumber blkno)
 {
 	int			i;
+	int			nresummarize = 0;
 	bool		result = false;
 
 	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
 
+	/*
+	 * If an identical request is already queued and not yet being worked on,
+	 * there's no point in recording it again.
+	 */
+	for (i = 0; i < NUM_WORKITEMS; i++)
+	{
+		AutoVacuumWorkItem *workitem = &AutoVacuumShmem->av_workItems[i];
+
+		if (workitem->avw_used &&
+			workitem->avw_type == AVW_BRINResummarizeRange)
+			nresummarize++;
+
+		if (workitem->avw_used && !workitem->avw_active &&
+			workitem->avw_type == type &&
+			workitem->avw_database == MyDatabaseId &&
+			workitem->avw_relation == relationId &&
+			workitem->avw_blockNumber == blkno)
+		{
+			LWLockRelease(AutovacuumLock);
+			return true;
+		}
+	}
+
+	/* Resummarization requests may only use part of the queue */
+	if (type == AVW_BRINResummarizeRange &&
+		nresummarize >= MAX_RESUMMARIZE_WORKITEMS)
+	{
+		LWLockRelease(AutovacuumLock);
+		return false;
+	}
+
 	/*
 	 * Locate an unused work item and fill it with the given data.
 	 */
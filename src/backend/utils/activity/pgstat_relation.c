@@ -485,6 +485,41 @@ pgstat_fetch_stat_tabentry_ext(bool shared, Oid reloid)
 		pgstat_fetch_entry(PGSTAT_KIND_RELATION, dboid, reloid);
 }
 
+/*
+ * Read a table's cumulative insert and update counters straight from shared
+ * memory.  Unlike pgstat_fetch_stat_tabentry(), this doesn't go through (or
+ * populate) the stats snapshot, so it doesn't change what the SQL-callable
+ * functions show later in the transaction.  Returns false if there are no
+ * statistics for the table.
+ */
+bool
+pgstat_fetch_tab_update_counts(Relation rel,
+							   PgStat_Counter *tuples_inserted,
+							   PgStat_Counter *tuples_updated,
+							   PgStat_Counter *tuples_newpage_updated)
+{
+	Oid			dboid = (rel->rd_rel->relisshared ? InvalidOid : MyDatabaseId);
+	PgStat_EntryRef *entry_ref;
+	PgStat_StatTabEntry *tabentry;
+
+	if (!pgstat_track_counts)
+		return false;
+
+	entry_ref = pgstat_get_entry_ref(PGSTAT_KIND_RELATION, dboid,
+									 RelationGetRelid(rel), false, NULL);
+	if (entry_ref == NULL)
+		return false;
+
+	pgstat_lock_entry_shared(entry_ref, false);
+	tabentry = &((PgStatShared_Relation *) entry_ref->shared_stats)->stats;
+	*tuples_inserted = tabentry->tuples_inserted;
+	*tuples_updated = tabentry->tuples_updated;
+	*tuples_newpage_updated = tabentry->tuples_newpage_updated;
+	pgstat_unlock_entry(entry_ref);
+
+	return true;
+}
+
 /*
  * find any existing PgStat_TableStatus entry for rel
  *
@@ -117,6 +117,10 @@ typedef IndexBuildResult *(*ambuild_function) (Relation heapRelation,
 /* build empty index */
 typedef void (*ambuildempty_function) (Relation indexRelation);
 
+/* will a parallel build of this index make use of parallel workers? */
+typedef bool (*ambuildusesworkers_function) (Relation heapRelation,
+											 Relation indexRelation);
+
 /* insert this tuple */
 typedef bool (*aminsert_function) (Relation indexRelation,
 								   Datum *values,
@@ -294,6 +298,7 @@ typedef struct IndexAmRoutine
 	/* interface functions */
 	ambuild_function ambuild;
 	ambuildempty_function ambuildempty;
+	ambuildusesworkers_function ambuildusesworkers; /* can be NULL */
 	aminsert_function aminsert;
 	aminsertcleanup_function aminsertcleanup;	/* can be NULL */
 	ambulkdelete_function ambulkdelete;
@@ -52,6 +52,15 @@ extern struct varlena *detoast_external_attr(struct varlena *attr);
  */
 extern struct varlena *detoast_attr(struct varlena *attr);
 
+/* ----------
+ * detoast_attr_into() -
+ *
+ *		Fully detoasts one attribute into caller-supplied memory,
+ *		writing only the data bytes, not a varlena header.
+ * ----------
+ */
+extern void detoast_attr_into(struct varlena *attr, char *dest);
+
 /* ----------
  * detoast_attr_slice() -
  *
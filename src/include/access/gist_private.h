@@ -254,6 +254,7 @@ typedef struct
 	Relation	heapRel;
 	Size		freespace;		/* free space to be left */
 	bool		is_build;
+	bool		indexUnchanged; /* new version of row with unchanged key? */
 
 	GISTInsertStack *stack;
 } GISTInsertState;
@@ -413,7 +414,8 @@ extern void gistdoinsert(Relation r,
 						 Size freespace,
 						 GISTSTATE *giststate,
 						 Relation heapRel,
-						 bool is_build);
+						 bool is_build,
+						 bool indexUnchanged);
 
 /* A List of these is returned from gistplacetopage() in *splitinfo */
 typedef struct
@@ -550,6 +552,7 @@ extern void gistSplitByKey(Relation r, Page page, IndexTuple *itup,
 /* gistbuild.c */
 extern IndexBuildResult *gistbuild(Relation heap, Relation index,
 								   struct IndexInfo *indexInfo);
+extern bool gistbuildusesworkers(Relation heap, Relation index);
 
 /* gistbuildbuffers.c */
 extern GISTBuildBuffers *gistInitBuildBuffers(int pagesPerBuffer, int levelStep,
@@ -845,6 +845,26 @@ typedef struct BTInsertStateData
 
 typedef BTInsertStateData *BTInsertState;
 
+/*
+ * BTInsertCacheData remembers the leaf page that received the last insert
+ * made through a given IndexInfo, which normally lasts for one statement
+ * (e.g. a COPY or a multi-row INSERT).  It's kept in ii_AmCache.
+ *
+ * When successive new tuples belong on the same leaf page, as happens when
+ * loading data that is clustered on the index key, the cached page lets
+ * _bt_search_insert() skip descending the tree.  Caching stops once it has
+ * proven useless for the statement, so that inserts in random key order
+ * don't pay for repeatedly checking the wrong page.
+ */
+typedef struct BTInsertCacheData
+{
+	BlockNumber leafblk;		/* leaf page of last insert, or Invalid */
+	uint32		nhits;			/* number of inserts that used leafblk */
+	uint32		nmisses;		/* number of times leafblk was unsuitable */
+} BTInsertCacheData;
+
+typedef BTInsertCacheData *BTInsertCache;
+
 /*
  * State used to representing an individual pending tuple during
  * deduplication.
@@ -1153,6 +1173,7 @@ typedef struct BTOptions
 	int			fillfactor;		/* page fill factor in percent (0..100) */
 	float8		vacuum_cleanup_index_scale_factor;	/* deprecated */
 	bool		deduplicate_items;	/* Try to deduplicate items? */
+	bool		interpolation_search;	/* Interpolate binary search probes? */
 } BTOptions;
 
 #define BTGetFillFactor(relation) \
@@ -1168,6 +1189,11 @@ typedef struct BTOptions
 				 relation->rd_rel->relam == BTREE_AM_OID), \
 	((relation)->rd_options ? \
 	 ((BTOptions *) (relation)->rd_options)->deduplicate_items : true))
+#define BTGetInterpolationSearch(relation) \
+	(AssertMacro(relation->rd_rel->relkind == RELKIND_INDEX && \
+				 relation->rd_rel->relam == BTREE_AM_OID), \
+	((relation)->rd_options ? \
+	 ((BTOptions *) (relation)->rd_options)->interpolation_search : false))
 
 /*
  * Constant definition for progress reporting.  Phase numbers must match
@@ -1245,7 +1271,7 @@ extern IndexTuple _bt_swap_posting(IndexTuple newitem, IndexTuple oposting,
  */
 extern bool _bt_doinsert(Relation rel, IndexTuple itup,
 						 IndexUniqueCheck checkUnique, bool indexUnchanged,
-						 Relation heapRel);
+						 Relation heapRel, BTInsertCache cache);
 extern void _bt_finish_split(Relation rel, Relation heaprel, Buffer lbuf,
 							 BTStack stack);
 extern Buffer _bt_getstackbuf(Relation rel, Relation heaprel, BTStack stack,
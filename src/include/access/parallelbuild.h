@@ -0,0 +1,177 @@
+/*-------------------------------------------------------------------------
+ *
+ * parallelbuild.h
+ *	  Infrastructure shared by parallel sort-based index builds.
+ *
+ * Copyright (c) 2025, PostgreSQL Global Development Group
+ *
+ * src/include/access/parallelbuild.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PARALLELBUILD_H
+#define PARALLELBUILD_H
+
+#include "access/parallel.h"
+#include "access/tableam.h"
+#include "executor/instrument.h"
+#include "storage/condition_variable.h"
+#include "storage/spin.h"
+#include "utils/tuplesort.h"
+
+/* Maximum number of shared tuplesorts a parallel build can use */
+#define PARALLEL_BUILD_MAX_SORTS	2
+
+/*
+ * Status for index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment.  Note that there are separate tuplesort TOC
+ * entries, private to tuplesort.c but allocated by parallelbuild.c on its
+ * behalf.
+ */
+typedef struct ParallelBuildShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			nsorts;
+	int			scantuplesortstates;
+	Size		amsharedsize;
+
+	/* Query ID, for report in worker processes */
+	int64		queryid;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can use
+	 * mutable state that workers maintain during scan (and before leader can
+	 * proceed to tuplesort_performsort()).
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before the AM-specific data.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of parallel scan.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * havedead indicates if RECENTLY_DEAD tuples were encountered during
+	 * build (only of interest to nbtree unique index builds).
+	 *
+	 * indtuples is the total number of tuples that made it into the index.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	double		reltuples;
+	bool		havedead;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * amsharedsize bytes of AM-specific data follow, and then the
+	 * ParallelTableScanDescData.  The latter can't be embedded directly, as
+	 * implementations of the parallel table scan desc interface might need
+	 * stronger alignment.
+	 */
+} ParallelBuildShared;
+
+/*
+ * Return pointer to a ParallelBuildShared's AM-specific data, and to its
+ * parallel table scan.
+ *
+ * c.f. shm_toc_allocate as to why BUFFERALIGN is used, rather than just
+ * MAXALIGN.
+ */
+#define ParallelBuildSharedGetAmShared(shared) \
+	((void *) ((char *) (shared) + BUFFERALIGN(sizeof(ParallelBuildShared))))
+#define ParallelTableScanFromParallelBuildShared(shared) \
+	(ParallelTableScanDesc) ((char *) (shared) + \
+							 BUFFERALIGN(sizeof(ParallelBuildShared)) + \
+							 BUFFERALIGN((shared)->amsharedsize))
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct ParallelBuildLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipanttuplesorts is the exact number of worker processes
+	 * successfully launched, plus one leader process if it participates as a
+	 * worker (only DISABLE_LEADER_PARTICIPATION builds avoid leader
+	 * participating as a worker).
+	 */
+	int			nparticipanttuplesorts;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 *
+	 * shared is the shared state for entire build.  sharedsort[] holds the
+	 * shared, tuplesort-managed state passed to each process tuplesort, one
+	 * per sort that each participant performs.  snapshot is the snapshot
+	 * used by the scan iff an MVCC snapshot is required.
+	 */
+	ParallelBuildShared *shared;
+	Sharedsort *sharedsort[PARALLEL_BUILD_MAX_SORTS];
+	Snapshot	snapshot;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+} ParallelBuildLeader;
+
+/*
+ * Callback used by parallel_build_begin() to have the leader perform its
+ * share of the scan and sort, while the workers do theirs.
+ */
+typedef void (*ParallelBuildParticipateCB) (ParallelBuildLeader *leader,
+											void *arg);
+
+extern ParallelBuildLeader *parallel_build_begin(const char *function_name,
+												 Relation heap, Relation index,
+												 bool isconcurrent, int request,
+												 int nsorts,
+												 const void *amshared,
+												 Size amsharedsize,
+												 ParallelBuildParticipateCB participate,
+												 void *arg);
+extern void parallel_build_end(ParallelBuildLeader *leader);
+extern double parallel_build_wait_scan(ParallelBuildLeader *leader,
+									   double *indtuples, bool *havedead,
+									   bool *brokenhotchain);
+extern SortCoordinate parallel_build_leader_coordinate(ParallelBuildLeader *leader,
+													   int sortno);
+
+extern ParallelBuildShared *parallel_build_worker_begin(dsm_segment *seg,
+														shm_toc *toc,
+														Relation *heapRel,
+														Relation *indexRel,
+														Sharedsort **sharedsort);
+extern void parallel_build_worker_end(shm_toc *toc,
+									  ParallelBuildShared *shared,
+									  Relation heapRel, Relation indexRel);
+extern SortCoordinate parallel_build_worker_coordinate(Sharedsort *sharedsort);
+extern double parallel_build_scan(ParallelBuildShared *shared,
+								  Relation heap, Relation index, bool progress,
+								  IndexBuildCallback callback,
+								  void *callback_state,
+								  bool *brokenhotchain);
+extern void parallel_build_scan_done(ParallelBuildShared *shared,
+									 double reltuples, double indtuples,
+									 bool havedead, bool brokenhotchain);
+
+#endif							/* PARALLELBUILD_H */
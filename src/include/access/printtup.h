@@ -23,6 +23,8 @@ extern void SetRemoteDestReceiverParams(DestReceiver *self, Portal portal);
 extern void SendRowDescriptionMessage(StringInfo buf,
 									  TupleDesc typeinfo, List *targetlist, int16 *formats);
 
+extern void SendBinaryAttribute(StringInfo buf, FmgrInfo *finfo, Datum attr);
+
 extern void debugStartup(DestReceiver *self, int operation,
 						 TupleDesc typeinfo);
 extern bool debugtup(TupleTableSlot *slot, DestReceiver *self);
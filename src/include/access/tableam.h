@@ -1889,7 +1889,10 @@ table_relation_toast_am(Relation rel)
  * fetched.
  *
  * result is caller-allocated space into which the fetched bytes should be
- * stored.
+ * stored, starting at VARDATA(result).  The callback must neither read nor
+ * write the varlena header of result; the caller sets it.  detoast_attr_into()
+ * relies on this to fetch a value directly into a buffer that has no header
+ * of its own, by passing a pointer VARHDRSZ bytes before the buffer.
  */
 static inline void
 table_relation_fetch_toast_slice(Relation toastrel, Oid valueid,
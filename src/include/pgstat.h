@@ -737,6 +737,10 @@ extern void pgstat_twophase_postabort(FullTransactionId fxid, uint16 info,
 extern PgStat_StatTabEntry *pgstat_fetch_stat_tabentry(Oid relid);
 extern PgStat_StatTabEntry *pgstat_fetch_stat_tabentry_ext(bool shared,
 														   Oid reloid);
+extern bool pgstat_fetch_tab_update_counts(Relation rel,
+										   PgStat_Counter *tuples_inserted,
+										   PgStat_Counter *tuples_updated,
+										   PgStat_Counter *tuples_newpage_updated);
 extern PgStat_TableStatus *find_tabstat_entry(Oid rel_id);
 
 
@@ -342,6 +342,7 @@ typedef struct StdRdOptions
 {
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
 	int			fillfactor;		/* page fill factor in percent (0..100) */
+	bool		fillfactor_set; /* whether fillfactor is set */
 	int			toast_tuple_target; /* target for tuple toasting */
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
@@ -376,6 +377,15 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->fillfactor : (defaultff))
 
+/*
+ * RelationFillFactorIsSet
+ *		Returns whether the relation's fillfactor was set explicitly, rather
+ *		than defaulted.  Note multiple eval of argument!
+ */
+#define RelationFillFactorIsSet(relation) \
+	((relation)->rd_options ? \
+	 ((StdRdOptions *) (relation)->rd_options)->fillfactor_set : false)
+
 /*
  * RelationGetTargetPageUsage
  *		Returns the relation's desired space usage per page in bytes.
@@ -79,6 +79,23 @@ $count = $node->safe_psql(
 );
 cmp_ok($count, '>', '1', "$count brin_packdate_idx ranges got summarized");
 
+# Widening the summary of a range that isn't the last one in the table
+# should get that range resummarized, so that the values of tuples that are
+# gone no longer count.
+$node->safe_psql('postgres', 'update brin_wi set a = 1000 where a = 1');
+
+$node->poll_query_until(
+	'postgres',
+	"select value = '{2 .. 1000}' from brin_page_items(get_raw_page('brin_wi_idx', 2), 'brin_wi_idx'::regclass)
+	 where blknum = 0",
+	't');
+
+my $value = $node->safe_psql('postgres',
+	"select value from brin_page_items(get_raw_page('brin_wi_idx', 2), 'brin_wi_idx'::regclass)
+	 where blknum = 0"
+);
+is($value, '{2 .. 1000}', "widened brin_wi_idx range got resummarized");
+
 $node->stop;
 
 done_testing();
@@ -304,6 +304,7 @@ dihandler(PG_FUNCTION_ARGS)
 
 	amroutine->ambuild = dibuild;
 	amroutine->ambuildempty = dibuildempty;
+	amroutine->ambuildusesworkers = NULL;
 	amroutine->aminsert = diinsert;
 	amroutine->ambulkdelete = dibulkdelete;
 	amroutine->amvacuumcleanup = divacuumcleanup;
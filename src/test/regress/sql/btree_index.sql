@@ -438,3 +438,117 @@ CREATE TABLE btree_part (id int4) PARTITION BY RANGE (id);
 CREATE INDEX btree_part_idx ON btree_part(id);
 ALTER INDEX btree_part_idx ALTER COLUMN id SET (n_distinct=100);
 DROP TABLE btree_part;
+
+--
+-- Test binary searches that skip key prefixes known to be equal.  Leading
+-- columns repeat within each leaf page, so most comparisons start past them.
+--
+CREATE TABLE btree_prefix (a text, b text, c int4);
+INSERT INTO btree_prefix SELECT 'prefix-' || (g % 3), 'middle-' || (g % 7), g
+FROM generate_series(1, 10000) g;
+CREATE UNIQUE INDEX btree_prefix_idx ON btree_prefix (a, b, c);
+-- These inserts use _bt_binsrch_insert()
+INSERT INTO btree_prefix SELECT 'prefix-' || (g % 3), 'middle-' || (g % 7), g
+FROM generate_series(10001, 12000) g;
+INSERT INTO btree_prefix VALUES ('prefix-1', 'middle-3', 10);
+
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+SELECT count(*), min(c), max(c) FROM btree_prefix
+WHERE a = 'prefix-1' AND b = 'middle-3';
+SELECT c FROM btree_prefix
+WHERE a = 'prefix-2' AND b = 'middle-6' AND c > 11900 ORDER BY a, b, c;
+SELECT a, b, c FROM btree_prefix
+WHERE a = 'prefix-0' AND b = 'middle-0' ORDER BY a DESC, b DESC, c DESC LIMIT 3;
+SELECT count(*) FROM btree_prefix WHERE a = 'prefix-0' AND b < 'middle-2';
+SELECT a, b, c FROM btree_prefix
+WHERE (a, b, c) > ('prefix-1', 'middle-6', 11990) ORDER BY a, b, c LIMIT 4;
+reset enable_seqscan;
+reset enable_bitmapscan;
+DROP TABLE btree_prefix;
+
+--
+-- Test interpolated binary searches on integer and datetime keys, with
+-- skewed distributions and many duplicates.
+--
+CREATE TABLE btree_interp (i4 int4, i8 int8, ts timestamp, d date);
+CREATE INDEX btree_interp_i4 ON btree_interp (i4)
+  WITH (deduplicate_items = off, interpolation_search = on);
+CREATE INDEX btree_interp_i8 ON btree_interp (i8) WITH (interpolation_search = on);
+CREATE INDEX btree_interp_ts ON btree_interp (ts) WITH (interpolation_search = on);
+CREATE INDEX btree_interp_d ON btree_interp (d) WITH (interpolation_search = on);
+INSERT INTO btree_interp
+SELECT CASE WHEN g % 3 = 0 THEN 1000 ELSE g * g END,
+       CASE WHEN g <= 10 THEN -9223372036854775807 + g
+            WHEN g > 19990 THEN 9223372036854775807 - (20000 - g)
+            ELSE g * 1000000000::int8 END,
+       timestamp '2000-01-01' + CASE WHEN g % 2 = 0 THEN 0 ELSE g * g END * interval '1 second',
+       date '2000-01-01' + CASE WHEN g % 4 = 0 THEN 0 ELSE g END
+FROM generate_series(1, 20000) g;
+
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+SELECT count(*) FROM btree_interp WHERE i4 = 1000;
+SELECT count(*) FROM btree_interp WHERE i4 = 10000;
+SELECT count(*) FROM btree_interp WHERE i4 = 9999;
+SELECT count(*) FROM btree_interp WHERE i4 < 1000;
+SELECT count(*) FROM btree_interp WHERE i4 BETWEEN 1000000 AND 4000000;
+SELECT i4 FROM btree_interp WHERE i4 > 399000000 ORDER BY i4 LIMIT 3;
+-- cross-type comparisons use a plain binary search
+SELECT count(*) FROM btree_interp WHERE i4 = 10000::int8;
+SELECT count(*) FROM btree_interp WHERE i8 = -9223372036854775803;
+SELECT count(*) FROM btree_interp WHERE i8 >= 9223372036854775800;
+SELECT count(*) FROM btree_interp WHERE i8 = 5000000000000;
+SELECT count(*) FROM btree_interp WHERE i8 < 0;
+SELECT count(*) FROM btree_interp WHERE ts = '2000-01-01';
+SELECT count(*) FROM btree_interp WHERE ts = '2000-01-01 02:43:21';
+SELECT count(*) FROM btree_interp WHERE ts BETWEEN '2000-01-02' AND '2000-01-03';
+SELECT count(*) FROM btree_interp WHERE ts > '2000-01-05';
+SELECT count(*) FROM btree_interp WHERE d = '2000-01-01';
+SELECT count(*) FROM btree_interp WHERE d = date '2000-01-01' + 5001;
+SELECT count(*) FROM btree_interp
+WHERE d BETWEEN date '2000-01-01' + 100 AND date '2000-01-01' + 200;
+reset enable_seqscan;
+reset enable_bitmapscan;
+DROP TABLE btree_interp;
+
+--
+-- Test the per-statement leaf page cache used by inserts
+--
+CREATE TABLE btree_insertcache (k int4) WITH (autovacuum_enabled = off);
+CREATE INDEX btree_insertcache_idx ON btree_insertcache (k)
+  WITH (deduplicate_items = off);
+INSERT INTO btree_insertcache SELECT g * 10 FROM generate_series(1, 10000) g;
+-- Clustered keys in the middle of the index.  Once the first one has
+-- descended the tree, the rest go straight to the cached leaf page, until it
+-- is full and has to be split.
+INSERT INTO btree_insertcache SELECT g * 10 + 5 FROM generate_series(4000, 6000) g;
+-- Split the cached leaf page from another statement halfway through the
+-- insert.  The cached page's high key no longer covers the keys that follow,
+-- so those must descend the tree again.
+CREATE FUNCTION btree_insertcache_split(base int4) RETURNS int4 LANGUAGE plpgsql AS $$
+BEGIN
+  INSERT INTO btree_insertcache SELECT base + 1 FROM generate_series(1, 1000);
+  RETURN base + 3;
+END $$;
+INSERT INTO btree_insertcache
+SELECT CASE WHEN g = 7000 THEN btree_insertcache_split(g * 10) ELSE g * 10 + 3 END
+FROM generate_series(6900, 7100) g;
+
+set enable_seqscan to false;
+set enable_bitmapscan to false;
+set enable_hashjoin to false;
+set enable_mergejoin to false;
+SELECT count(*) FROM btree_insertcache;
+SELECT count(*) FROM btree_insertcache WHERE k BETWEEN 40000 AND 60010;
+SELECT count(*) FROM btree_insertcache WHERE k = 70001;
+SELECT count(*) FROM btree_insertcache WHERE k BETWEEN 69000 AND 71010;
+-- Every tuple must be where a descent from the root looks for it
+SELECT count(*) FROM btree_insertcache t
+WHERE NOT EXISTS (SELECT 1 FROM btree_insertcache u WHERE u.k = t.k);
+reset enable_seqscan;
+reset enable_bitmapscan;
+reset enable_hashjoin;
+reset enable_mergejoin;
+DROP TABLE btree_insertcache;
+DROP FUNCTION btree_insertcache_split(int4);
@@ -419,3 +419,17 @@ CREATE TABLE pp_510 PARTITION OF pp_2 FOR VALUES FROM (5) TO (10);
 INSERT INTO pp SELECT g, 10 + g FROM generate_series(1,6) g;
 COPY pp TO stdout(header);
 DROP TABLE PP;
+
+-- Test binary COPY TO of bytea values stored out of line, which are
+-- detoasted straight into the output buffer.
+CREATE TABLE copytest_bytea (id int, b bytea);
+ALTER TABLE copytest_bytea ALTER COLUMN b SET STORAGE EXTERNAL;
+INSERT INTO copytest_bytea VALUES (1, NULL), (2, '\x0102'),
+  (3, convert_to(repeat('abcdefghij', 1000), 'UTF8'));
+\set filename :abs_builddir '/results/copytest_bytea.data'
+COPY copytest_bytea TO :'filename' (FORMAT binary);
+CREATE TABLE copytest_bytea2 (LIKE copytest_bytea);
+COPY copytest_bytea2 FROM :'filename' (FORMAT binary);
+SELECT a.id, length(b.b), a.b IS NOT DISTINCT FROM b.b AS same
+  FROM copytest_bytea a JOIN copytest_bytea2 b USING (id) ORDER BY id;
+DROP TABLE copytest_bytea, copytest_bytea2;
@@ -37,6 +37,27 @@ vacuum analyze gist_point_tbl;
 alter index gist_pointidx SET (fillfactor = 40);
 reindex index gist_pointidx;
 
+-- rebuild the index in parallel; only sorted builds use the workers, as
+-- the DEBUG message about the planned number of workers shows
+alter table gist_point_tbl set (parallel_workers = 2);
+begin;
+set local max_parallel_maintenance_workers = 4;
+set local client_min_messages = debug1;
+reindex index gist_pointidx;
+reset client_min_messages;
+create index gist_pointidx_buffered on gist_point_tbl using gist(p) with (buffering = on);
+commit;
+drop index gist_pointidx_buffered;
+alter table gist_point_tbl reset (parallel_workers);
+
+-- check that the index finds the expected rows
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(20000,20000));
+select count(*) from gist_point_tbl where p <@ box(point(10000,10000), point(30000,30000));
+reset enable_seqscan;
+reset enable_bitmapscan;
+
 --
 -- Test Index-only plans on GiST indexes
 --
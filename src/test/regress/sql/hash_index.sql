@@ -257,6 +257,25 @@ VACUUM hash_split_heap;
 ALTER INDEX hash_split_index SET (fillfactor = 10);
 REINDEX INDEX hash_split_index;
 
+-- Rebuild it in parallel.  The low maintenance_work_mem setting makes the
+-- build sort, which is the only case that uses workers; parallel_workers
+-- keeps the planner from capping the workers by maintenance_work_mem.  The
+-- DEBUG message shows the number of workers planned for the build.
+ALTER TABLE hash_split_heap SET (parallel_workers = 2);
+BEGIN;
+SET LOCAL maintenance_work_mem = '1MB';
+SET LOCAL max_parallel_maintenance_workers = 2;
+SET LOCAL client_min_messages = debug1;
+REINDEX INDEX hash_split_index;
+COMMIT;
+
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = OFF;
+SELECT count(*) FROM hash_split_heap WHERE keycol = 1;
+SELECT count(*) FROM hash_split_heap WHERE keycol = 12500;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
 -- Clean up.
 DROP TABLE hash_split_heap;
 
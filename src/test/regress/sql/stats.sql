@@ -944,4 +944,26 @@ SELECT * FROM check_estimated_rows('SELECT * FROM table_fillfactor');
 
 DROP TABLE table_fillfactor;
 
+-- Test the adaptive free space reserve.  Updates that have to move rows
+-- to other pages make later inserts leave room on each page, unless the
+-- fillfactor is set explicitly.
+CREATE TABLE heap_reserve (id int, pad text) WITH (autovacuum_enabled = off);
+CREATE TABLE heap_reserve_ff (id int, pad text)
+  WITH (autovacuum_enabled = off, fillfactor = 100);
+INSERT INTO heap_reserve SELECT g, repeat('x', 200) FROM generate_series(1, 2000) g;
+INSERT INTO heap_reserve_ff SELECT g, repeat('x', 200) FROM generate_series(1, 2000) g;
+UPDATE heap_reserve SET id = id;
+UPDATE heap_reserve_ff SET id = id;
+SELECT pg_stat_force_next_flush();
+-- reconnect, so that the reserve is computed afresh
+\c
+INSERT INTO heap_reserve SELECT g, repeat('x', 200) FROM generate_series(10001, 11000) g;
+INSERT INTO heap_reserve_ff SELECT g, repeat('x', 200) FROM generate_series(10001, 11000) g;
+SELECT (SELECT max(n) FROM (SELECT count(*) AS n FROM heap_reserve
+                            WHERE id > 10000 GROUP BY (ctid::text::point)[0]) s) <
+       (SELECT max(n) FROM (SELECT count(*) AS n FROM heap_reserve_ff
+                            WHERE id > 10000 GROUP BY (ctid::text::point)[0]) s)
+  AS reserved;
+DROP TABLE heap_reserve, heap_reserve_ff;
+
 -- End of Stats Test